@@ -0,0 +1,362 @@
+#include "LinuxBackend.h"
+#include "Debouncer.h"
+
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <linux/input.h>
+
+// ---- timerfd clock ----
+LinuxClock::LinuxClock(){
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+LinuxClock::~LinuxClock(){
+    if(timerFd >= 0) close(timerFd);
+    if(wakeFd >= 0) close(wakeFd);
+}
+
+uint64_t LinuxClock::NowNs(){
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void LinuxClock::SleepNs(uint64_t ns){
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000ull);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000ull);
+    while(clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) != 0) {}
+}
+
+void LinuxClock::WaitUntil(uint64_t deadlineNs){
+    pollfd fds[2];
+    fds[0].fd = wakeFd;   fds[0].events = POLLIN; fds[0].revents = 0;
+    fds[1].fd = timerFd;  fds[1].events = POLLIN; fds[1].revents = 0;
+    int nfds = 1;
+    if(deadlineNs != kForever){
+        if(deadlineNs <= NowNs()) return;
+        itimerspec its = {};
+        its.it_value.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ull);
+        its.it_value.tv_nsec = static_cast<long>(deadlineNs % 1000000000ull);
+        timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &its, nullptr);
+        nfds = 2;
+    }
+    poll(fds, nfds, -1);
+    uint64_t drain;
+    if(fds[0].revents & POLLIN){ ssize_t r = read(wakeFd, &drain, sizeof(drain)); (void)r; }
+    if(fds[1].revents & POLLIN){ ssize_t r = read(timerFd, &drain, sizeof(drain)); (void)r; }
+    if(nfds == 2 && !(fds[1].revents & POLLIN)){
+        itimerspec off = {};
+        timerfd_settime(timerFd, 0, &off, nullptr);
+    }
+}
+
+void LinuxClock::Wake(){
+    uint64_t one = 1;
+    ssize_t r = write(wakeFd, &one, sizeof(one));
+    (void)r;
+}
+
+// ---- inotify watcher ----
+LinuxDirWatcher::~LinuxDirWatcher(){
+    Stop();
+}
+
+bool LinuxDirWatcher::Start(const std::string &dir, ChangeFn fn){
+    if(thread.joinable()) return false;
+    inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if(inotifyFd < 0) return false;
+    // Editors either rewrite in place or write a temp file and rename it over the original
+    if(inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0){
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    onChanged = fn;
+    thread = std::thread(&LinuxDirWatcher::Run, this);
+    return true;
+}
+
+void LinuxDirWatcher::Stop(){
+    if(!thread.joinable()) return;
+    uint64_t one = 1;
+    ssize_t r = write(stopFd, &one, sizeof(one));
+    (void)r;
+    thread.join();
+    close(inotifyFd);
+    close(stopFd);
+    inotifyFd = stopFd = -1;
+}
+
+void LinuxDirWatcher::Run(){
+    LinuxClock clock;
+    Debouncer debounce(debounceNs);
+    alignas(inotify_event) char buf[4096];
+    for(;;){
+        uint64_t due = debounce.NextDueNs();
+        int timeoutMs = -1;
+        if(due != Debouncer::kNone){
+            uint64_t now = clock.NowNs();
+            timeoutMs = due > now ? static_cast<int>((due - now + 999999) / 1000000) : 0;
+        }
+        pollfd fds[2];
+        fds[0].fd = stopFd;    fds[0].events = POLLIN; fds[0].revents = 0;
+        fds[1].fd = inotifyFd; fds[1].events = POLLIN; fds[1].revents = 0;
+        poll(fds, 2, timeoutMs);
+        if(fds[0].revents & POLLIN) return;
+        if(fds[1].revents & POLLIN){
+            ssize_t len;
+            while((len = read(inotifyFd, buf, sizeof(buf))) > 0){
+                uint64_t now = clock.NowNs();
+                for(char *p = buf; p < buf + len;){
+                    const inotify_event *ev = reinterpret_cast<const inotify_event*>(p);
+                    if(ev->len > 0) debounce.Touch(ev->name, now);
+                    p += sizeof(inotify_event) + ev->len;
+                }
+            }
+        }
+        debounce.Flush(clock.NowNs(), onChanged);
+    }
+}
+
+// ---- evdev source ----
+// evdev key codes to the Win32 VKs profiles use, for the keys a profile can name.
+// Modifiers map to their left/right VKs, as the low-level hooks report them.
+static const struct { uint16_t code; uint8_t vk; } kEvdevKeys[] = {
+    { KEY_ESC, 0x1B }, { KEY_1, '1' }, { KEY_2, '2' }, { KEY_3, '3' }, { KEY_4, '4' }, { KEY_5, '5' },
+    { KEY_6, '6' }, { KEY_7, '7' }, { KEY_8, '8' }, { KEY_9, '9' }, { KEY_0, '0' },
+    { KEY_MINUS, 0xBD }, { KEY_EQUAL, 0xBB }, { KEY_BACKSPACE, 0x08 }, { KEY_TAB, 0x09 },
+    { KEY_Q, 'Q' }, { KEY_W, 'W' }, { KEY_E, 'E' }, { KEY_R, 'R' }, { KEY_T, 'T' }, { KEY_Y, 'Y' },
+    { KEY_U, 'U' }, { KEY_I, 'I' }, { KEY_O, 'O' }, { KEY_P, 'P' }, { KEY_LEFTBRACE, 0xDB },
+    { KEY_RIGHTBRACE, 0xDD }, { KEY_ENTER, 0x0D }, { KEY_LEFTCTRL, 0xA2 },
+    { KEY_A, 'A' }, { KEY_S, 'S' }, { KEY_D, 'D' }, { KEY_F, 'F' }, { KEY_G, 'G' }, { KEY_H, 'H' },
+    { KEY_J, 'J' }, { KEY_K, 'K' }, { KEY_L, 'L' }, { KEY_SEMICOLON, 0xBA }, { KEY_APOSTROPHE, 0xDE },
+    { KEY_GRAVE, 0xC0 }, { KEY_LEFTSHIFT, 0xA0 }, { KEY_BACKSLASH, 0xDC },
+    { KEY_Z, 'Z' }, { KEY_X, 'X' }, { KEY_C, 'C' }, { KEY_V, 'V' }, { KEY_B, 'B' }, { KEY_N, 'N' },
+    { KEY_M, 'M' }, { KEY_COMMA, 0xBC }, { KEY_DOT, 0xBE }, { KEY_SLASH, 0xBF }, { KEY_RIGHTSHIFT, 0xA1 },
+    { KEY_KPASTERISK, 0x6A }, { KEY_LEFTALT, 0xA4 }, { KEY_SPACE, 0x20 }, { KEY_CAPSLOCK, 0x14 },
+    { KEY_F1, 0x70 }, { KEY_F2, 0x71 }, { KEY_F3, 0x72 }, { KEY_F4, 0x73 }, { KEY_F5, 0x74 },
+    { KEY_F6, 0x75 }, { KEY_F7, 0x76 }, { KEY_F8, 0x77 }, { KEY_F9, 0x78 }, { KEY_F10, 0x79 },
+    { KEY_NUMLOCK, 0x90 }, { KEY_SCROLLLOCK, 0x91 },
+    { KEY_KP7, 0x67 }, { KEY_KP8, 0x68 }, { KEY_KP9, 0x69 }, { KEY_KPMINUS, 0x6D },
+    { KEY_KP4, 0x64 }, { KEY_KP5, 0x65 }, { KEY_KP6, 0x66 }, { KEY_KPPLUS, 0x6B },
+    { KEY_KP1, 0x61 }, { KEY_KP2, 0x62 }, { KEY_KP3, 0x63 }, { KEY_KP0, 0x60 }, { KEY_KPDOT, 0x6E },
+    { KEY_102ND, 0xE2 }, { KEY_F11, 0x7A }, { KEY_F12, 0x7B },
+    { KEY_KPENTER, 0x0D }, { KEY_RIGHTCTRL, 0xA3 }, { KEY_KPSLASH, 0x6F }, { KEY_SYSRQ, 0x2C },
+    { KEY_RIGHTALT, 0xA5 }, { KEY_HOME, 0x24 }, { KEY_UP, 0x26 }, { KEY_PAGEUP, 0x21 },
+    { KEY_LEFT, 0x25 }, { KEY_RIGHT, 0x27 }, { KEY_END, 0x23 }, { KEY_DOWN, 0x28 },
+    { KEY_PAGEDOWN, 0x22 }, { KEY_INSERT, 0x2D }, { KEY_DELETE, 0x2E }, { KEY_PAUSE, 0x13 },
+    { KEY_LEFTMETA, 0x5B }, { KEY_RIGHTMETA, 0x5C }, { KEY_COMPOSE, 0x5D },
+    { KEY_F13, 0x7C }, { KEY_F14, 0x7D }, { KEY_F15, 0x7E }, { KEY_F16, 0x7F }, { KEY_F17, 0x80 },
+    { KEY_F18, 0x81 }, { KEY_F19, 0x82 }, { KEY_F20, 0x83 }, { KEY_F21, 0x84 }, { KEY_F22, 0x85 },
+    { KEY_F23, 0x86 }, { KEY_F24, 0x87 },
+    { BTN_LEFT, kVkLButton }, { BTN_RIGHT, kVkRButton }, { BTN_MIDDLE, kVkMButton },
+    { BTN_SIDE, kVkXButton1 }, { BTN_EXTRA, kVkXButton2 },
+};
+
+static uint8_t EvdevVK(uint16_t code){
+    static uint8_t table[KEY_MAX + 1];
+    static bool built = false;
+    if(!built){
+        for(const auto &k : kEvdevKeys) table[k.code] = k.vk;
+        built = true;
+    }
+    return code <= KEY_MAX ? table[code] : 0;
+}
+
+LinuxEvdevSource::~LinuxEvdevSource(){
+    Stop();
+    Close();
+}
+
+bool LinuxEvdevSource::Open(const std::string &path){
+    Close();
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+    struct stat st;
+    device = fstat(fd, &st) == 0 && S_ISCHR(st.st_mode);
+    // A device is polled alongside the stop event; a recording simply reads to its end
+    if(device) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    finished = false;
+    haveOrigin = false;
+    head = tail = 0;
+    return true;
+}
+
+void LinuxEvdevSource::Close(){
+    if(fd >= 0) close(fd);
+    fd = -1;
+}
+
+bool LinuxEvdevSource::Start(IInputHandler *h){
+    if(thread.joinable() || fd < 0) return false;
+    handler = h;
+    stopping = false;
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    thread = std::thread(&LinuxEvdevSource::Run, this);
+    return true;
+}
+
+void LinuxEvdevSource::Stop(){
+    if(!thread.joinable()) return;
+    stopping = true;
+    uint64_t one = 1;
+    ssize_t r = write(stopFd, &one, sizeof(one));
+    (void)r;
+    thread.join();
+    close(stopFd);
+    stopFd = -1;
+    handler = nullptr;
+}
+
+// Refills the buffer once it is empty; false when nothing is available (yet)
+bool LinuxEvdevSource::Fill(){
+    if(head < tail) return true;
+    if(fd < 0) return false;
+    input_event raw[256];
+    ssize_t len = read(fd, raw, sizeof(raw));
+    // A trailing partial record of a truncated recording is dropped
+    size_t count = len > 0 ? static_cast<size_t>(len) / sizeof(input_event) : 0;
+    if(count == 0){
+        if(!device) finished = true;
+        return false;
+    }
+    for(size_t i = 0; i < count; ++i){
+        Record &r = buffer[i];
+        r.timeNs = static_cast<uint64_t>(raw[i].input_event_sec) * 1000000000ull +
+                   static_cast<uint64_t>(raw[i].input_event_usec) * 1000ull;
+        r.type = raw[i].type;
+        r.code = raw[i].code;
+        r.value = raw[i].value;
+    }
+    head = 0;
+    tail = count;
+    return true;
+}
+
+uint64_t LinuxEvdevSource::NextDueNs(){
+    if(!Fill()) return IClock::kForever;
+    if(!paced || device) return 0;
+    uint64_t t = buffer[head].timeNs;
+    if(!haveOrigin){
+        recordedOrigin = t;
+        clockOrigin = clock.NowNs();
+        haveOrigin = true;
+    }
+    return clockOrigin + (t > recordedOrigin ? t - recordedOrigin : 0);
+}
+
+// Key repeats (value 2) arrive as further presses, as they do through the hooks, and
+// wheel notches as wheel events. Everything else (SYN, MSC, motion) is skipped.
+void LinuxEvdevSource::Deliver(const Record &r, IInputHandler *to){
+    ++records;
+    InputEvent ev;
+    ev.vk = 0;
+    ev.down = false;
+    if(r.type == EV_REL && r.code == REL_WHEEL && r.value){
+        ev.wheel = static_cast<int16_t>(r.value * kWheelDelta);
+    } else if(r.type == EV_KEY && EvdevVK(r.code)){
+        ev.vk = EvdevVK(r.code);
+        ev.down = r.value != 0;
+    } else {
+        return;
+    }
+    ev.timeNs = clock.NowNs();
+    to->OnInput(ev);
+    ++delivered;
+}
+
+size_t LinuxEvdevSource::Pump(IInputHandler *to){
+    size_t n = 0;
+    for(;;){
+        uint64_t due = NextDueNs();
+        if(due == IClock::kForever || due > clock.NowNs()) return n;
+        Deliver(buffer[head++], to);
+        ++n;
+    }
+}
+
+void LinuxEvdevSource::Run(){
+    while(!stopping){
+        uint64_t due = NextDueNs();
+        uint64_t now = clock.NowNs();
+        if(due != IClock::kForever && due <= now){
+            Deliver(buffer[head++], handler);
+            continue;
+        }
+        if(due == IClock::kForever && !device) break;
+        pollfd fds[2];
+        fds[0].fd = stopFd; fds[0].events = POLLIN; fds[0].revents = 0;
+        fds[1].fd = fd;     fds[1].events = POLLIN; fds[1].revents = 0;
+        if(due == IClock::kForever){
+            poll(fds, 2, -1);
+        } else {
+            timespec ts;
+            ts.tv_sec = static_cast<time_t>((due - now) / 1000000000ull);
+            ts.tv_nsec = static_cast<long>((due - now) % 1000000000ull);
+            ppoll(fds, 1, &ts, nullptr);
+        }
+    }
+    finished = true;
+}
+
+// ---- Thread tuning ----
+// Both levels stay below the threaded interrupt handlers (priority 50), so the input
+// devices the capture thread waits on are still serviced ahead of it
+static const int kFifoHigh = 10;
+static const int kFifoRealtime = 40;
+
+bool LinuxThreadTuner::Apply(const ThreadPolicy &policy){
+    bool ok = true;
+    sched_param param = {};
+    int kind = SCHED_OTHER;
+    if(policy.priority != ThreadPolicy::NORMAL){
+        kind = SCHED_FIFO;
+        param.sched_priority = policy.priority == ThreadPolicy::REALTIME ? kFifoRealtime : kFifoHigh;
+    }
+    if(pthread_setschedparam(pthread_self(), kind, &param) != 0) ok = false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    for(int c = 0; c < CPU_SETSIZE; ++c){
+        if(policy.cores ? c < 64 && (policy.cores >> c & 1) != 0 : c < cpus) CPU_SET(c, &set);
+    }
+    if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) ok = false;
+    return ok;
+}
+
+// ---- Mapped file ----
+bool LinuxMappedFile::Open(const std::string &path){
+    Close();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size <= 0){
+        close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) return false;
+    data = static_cast<const uint8_t*>(p);
+    size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void LinuxMappedFile::Close(){
+    if(data) munmap(const_cast<uint8_t*>(data), size);
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Backend.h"
+
+// ---- Linux backend ----
+// CLOCK_MONOTONIC clock for running the engine's scheduler thread on real time on
+// Linux hosts. Deadlines are armed as absolute timerfd expirations so sleeping never
+// accumulates drift; an eventfd lets other threads cut a wait short. LinuxDirWatcher
+// reports profile edits through inotify and LinuxMappedFile maps compiled profiles.
+// LinuxEvdevSource reads an evdev device, or a file recorded from one, as input, and
+// LinuxThreadTuner moves threads to SCHED_FIFO and pins them to cores.
+
+class LinuxClock : public IClock {
+public:
+    LinuxClock();
+    ~LinuxClock();
+    uint64_t NowNs() override;
+    void SleepNs(uint64_t ns) override;
+    void WaitUntil(uint64_t deadlineNs) override;
+    void Wake() override;
+
+private:
+    int timerFd = -1;
+    int wakeFd = -1;
+};
+
+class LinuxDirWatcher : public IFileWatcher {
+public:
+    ~LinuxDirWatcher();
+    bool Start(const std::string &dir, ChangeFn onChanged) override;
+    void Stop() override;
+
+    // Quiet time after the last write before a file is reported
+    uint64_t debounceNs = 250000000;
+
+private:
+    void Run();
+
+    ChangeFn onChanged;
+    int inotifyFd = -1;
+    int stopFd = -1;
+    std::thread thread;
+};
+
+// Key and button transitions from an evdev node (/dev/input/eventN) or from a recording
+// of one (`cat /dev/input/eventN > keys.rec`): raw struct input_event records, decoded
+// to VKs and handed to the same OnInput as the Win32 sources. evdev cannot block input,
+// so the handler's suppress answer is ignored, as with Raw Input on Windows.
+class LinuxEvdevSource : public IInputSource {
+public:
+    explicit LinuxEvdevSource(IClock &clock) : clock(clock) {}
+    ~LinuxEvdevSource();
+    LinuxEvdevSource(const LinuxEvdevSource&) = delete;
+    LinuxEvdevSource& operator=(const LinuxEvdevSource&) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    // Reads on a thread of its own until Stop, or to the end of a recording
+    bool Start(IInputHandler *handler) override;
+    void Stop() override;
+    bool Finished() const { return finished.load(); }
+
+    // Headless use without Start: delivers every record due by the clock's now on the
+    // calling thread and returns how many were read. NextDueNs tells when the next one
+    // is due, kForever once a recording is exhausted.
+    size_t Pump(IInputHandler *handler);
+    uint64_t NextDueNs();
+
+    // Recordings only: keep the recorded spacing between events on the clock instead of
+    // delivering them as fast as they can be read
+    bool paced = false;
+
+    uint64_t records = 0;
+    uint64_t delivered = 0;
+
+private:
+    struct Record {
+        uint64_t timeNs;
+        uint16_t type;
+        uint16_t code;
+        int32_t value;
+    };
+
+    bool Fill();
+    void Deliver(const Record &r, IInputHandler *to);
+    void Run();
+
+    IClock &clock;
+    IInputHandler *handler = nullptr;
+    int fd = -1;
+    int stopFd = -1;
+    bool device = false;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> finished{false};
+    // Recorded time and clock time of the first record, the origin for paced delivery
+    bool haveOrigin = false;
+    uint64_t recordedOrigin = 0;
+    uint64_t clockOrigin = 0;
+    Record buffer[256];
+    size_t head = 0;
+    size_t tail = 0;
+    std::thread thread;
+};
+
+// SCHED_FIFO through pthread_setschedparam and core masks through pthread_setaffinity_np.
+// Realtime scheduling needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance (the rtprio
+// entry of limits.conf); without it Apply returns false and the thread stays SCHED_OTHER.
+class LinuxThreadTuner : public IThreadTuner {
+public:
+    bool Apply(const ThreadPolicy &policy) override;
+};
+
+// Read-only mapping of a whole file
+class LinuxMappedFile {
+public:
+    LinuxMappedFile() = default;
+    LinuxMappedFile(const LinuxMappedFile&) = delete;
+    LinuxMappedFile& operator=(const LinuxMappedFile&) = delete;
+    ~LinuxMappedFile(){ Close(); }
+
+    bool Open(const std::string &path);
+    void Close();
+    const uint8_t *Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+};
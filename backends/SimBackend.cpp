@@ -0,0 +1,34 @@
+#include "SimBackend.h"
+#include "Engine.h"
+
+// ---- Virtual-time scheduler driver ----
+void RunEngineUntil(Engine &engine, SimClock &clock, uint64_t untilNs){
+    for(;;){
+        uint64_t next = engine.RunDue(clock.NowNs());
+        if(next > untilNs) break;
+        clock.WaitUntil(next);
+    }
+    clock.AdvanceTo(untilNs);
+}
+
+// ---- SimInputSink ----
+void SimInputSink::Send(const InjectOp *ops, size_t count){
+    ++sendCalls;
+    uint64_t t = clock.NowNs();
+    for(size_t i = 0; i < count; ++i) records.push_back(Record{ t, ops[i] });
+}
+
+// ---- SimInputSource ----
+bool SimInputSource::Feed(uint8_t vk, bool down){
+    InputEvent ev = { 0, vk, down };
+    return Feed(ev);
+}
+
+bool SimInputSource::Feed(InputEvent ev){
+    if(!handler) return false;
+    ev.timeNs = clock.NowNs();
+    ++delivered;
+    bool s = handler->OnInput(ev);
+    if(s) ++suppressed;
+    return s;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Backend.h"
+
+class Engine;
+
+// ---- Simulated backend ----
+// In-memory input source, recording sink and virtual clock. Nothing here touches the OS,
+// so the engine can be driven deterministically from benchmarks on any host.
+
+class SimClock : public IClock {
+public:
+    uint64_t NowNs() override { return now; }
+    void SleepNs(uint64_t ns) override { now += ns; }
+    // Virtual time never blocks: waiting simply jumps to the deadline
+    void WaitUntil(uint64_t deadlineNs) override { if(deadlineNs != kForever && deadlineNs > now) now = deadlineNs; }
+    void Wake() override {}
+
+    void AdvanceTo(uint64_t t) { if(t > now) now = t; }
+
+private:
+    uint64_t now = 0;
+};
+
+// Runs the engine's scheduler on the virtual clock until untilNs, jumping from deadline to deadline
+void RunEngineUntil(Engine &engine, SimClock &clock, uint64_t untilNs);
+
+class SimInputSink : public IInputSink {
+public:
+    struct Record {
+        uint64_t timeNs;
+        InjectOp op;
+    };
+
+    explicit SimInputSink(IClock &clock) : clock(clock) {}
+    void Send(const InjectOp *ops, size_t count) override;
+    void Clear() { records.clear(); sendCalls = 0; }
+
+    std::vector<Record> records;
+    uint64_t sendCalls = 0;
+
+private:
+    IClock &clock;
+};
+
+class SimInputSource : public IInputSource {
+public:
+    explicit SimInputSource(IClock &clock) : clock(clock) {}
+    bool Start(IInputHandler *h) override { handler = h; return true; }
+    void Stop() override { handler = nullptr; }
+
+    // Delivers one event as the hooks would; returns true if it was suppressed
+    bool Feed(uint8_t vk, bool down);
+    // Same for a prepared event (a wheel movement, say), stamped with the clock's now
+    bool Feed(InputEvent ev);
+
+    uint64_t delivered = 0;
+    uint64_t suppressed = 0;
+
+private:
+    IClock &clock;
+    IInputHandler *handler = nullptr;
+};
+
+class SimForegroundWatcher : public IForegroundWatcher {
+public:
+    bool Start(ChangeFn fn) override { onChanged = fn; return true; }
+    void Stop() override { onChanged = nullptr; }
+
+    // Brings an application to the foreground, reporting it as the OS would
+    void Focus(const std::string &exe, const std::string &windowClass){ if(onChanged) onChanged(exe, windowClass); }
+
+private:
+    ChangeFn onChanged;
+};
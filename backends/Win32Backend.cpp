@@ -0,0 +1,554 @@
+#define UNICODE
+#include "Win32Backend.h"
+#include "Debouncer.h"
+#include "KeyMap.h"
+#include <avrt.h>
+#include <mmsystem.h>
+#include <vector>
+#pragma comment(lib, "winmm.lib")
+#pragma comment(lib, "avrt.lib")
+
+#ifndef LLKHF_INJECTED
+#define LLKHF_INJECTED 0x10
+#endif
+#ifndef LLMHF_INJECTED
+#define LLMHF_INJECTED 0x00000001
+#endif
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+static_assert(kKeyEventUp == KEYEVENTF_KEYUP, "InjectOp flags must match KEYEVENTF_*");
+static_assert(kMouseLeftDown == MOUSEEVENTF_LEFTDOWN && kMouseLeftUp == MOUSEEVENTF_LEFTUP, "InjectOp flags must match MOUSEEVENTF_*");
+static_assert(kMouseRightDown == MOUSEEVENTF_RIGHTDOWN && kMouseRightUp == MOUSEEVENTF_RIGHTUP, "InjectOp flags must match MOUSEEVENTF_*");
+static_assert(kMouseMiddleDown == MOUSEEVENTF_MIDDLEDOWN && kMouseMiddleUp == MOUSEEVENTF_MIDDLEUP, "InjectOp flags must match MOUSEEVENTF_*");
+static_assert(kMouseXDown == MOUSEEVENTF_XDOWN && kMouseXUp == MOUSEEVENTF_XUP, "InjectOp flags must match MOUSEEVENTF_*");
+static_assert(kMouseWheel == MOUSEEVENTF_WHEEL && kWheelDelta == WHEEL_DELTA, "InjectOp flags must match MOUSEEVENTF_*");
+static_assert(kXButton1 == XBUTTON1 && kXButton2 == XBUTTON2, "InjectOp flags must match XBUTTON*");
+static_assert(kVkLButton == VK_LBUTTON && kVkXButton2 == VK_XBUTTON2 && kVkF1 == VK_F1, "VK constants must match <windows.h>");
+
+// ---- Low-level hooks ----
+IInputHandler *Win32HookSource::handler = nullptr;
+IClock *Win32HookSource::clock = nullptr;
+HHOOK Win32HookSource::gKeyboardHook = nullptr;
+HHOOK Win32HookSource::gMouseHook = nullptr;
+
+bool Win32HookSource::Start(IInputHandler *h){
+    if(thread.joinable()) return false;
+    handler = h;
+    HANDLE ready = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    thread = std::thread(&Win32HookSource::Run, this, ready);
+    WaitForSingleObject(ready, INFINITE);
+    CloseHandle(ready);
+    if(!installed){
+        thread.join();
+        handler = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void Win32HookSource::Stop(){
+    if(!thread.joinable()) return;
+    PostThreadMessageW(threadId, WM_QUIT, 0, 0);
+    thread.join();
+    handler = nullptr;
+}
+
+// Low-level hooks are called through the message loop of the thread that set them
+void Win32HookSource::Run(HANDLE ready){
+    MSG msg;
+    // Create the message queue before Stop can post to it
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    threadId = GetCurrentThreadId();
+    gKeyboardHook = SetWindowsHookExW(WH_KEYBOARD_LL, LowLevelKeyboardProc, nullptr, 0);
+    gMouseHook = SetWindowsHookExW(WH_MOUSE_LL, LowLevelMouseProc, nullptr, 0);
+    installed = gKeyboardHook != nullptr && gMouseHook != nullptr;
+    SetEvent(ready);
+    if(installed){
+        while(GetMessageW(&msg, nullptr, 0, 0) > 0) DispatchMessageW(&msg);
+    }
+    if(gKeyboardHook) { UnhookWindowsHookEx(gKeyboardHook); gKeyboardHook = nullptr; }
+    if(gMouseHook)    { UnhookWindowsHookEx(gMouseHook);    gMouseHook = nullptr; }
+    installed = false;
+}
+
+LRESULT CALLBACK Win32HookSource::LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam){
+    if(nCode < HC_ACTION || !handler) return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
+    auto info = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
+    if(!info) return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
+    if((info->flags & LLKHF_INJECTED) != 0) return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
+    if(info->vkCode > 0xFF) return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
+
+    InputEvent ev;
+    ev.timeNs = clock->NowNs();
+    ev.vk = static_cast<uint8_t>(info->vkCode);
+    ev.down = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+    if(handler->OnInput(ev)) return 1;
+    return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
+}
+
+LRESULT CALLBACK Win32HookSource::LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam){
+    if(nCode < HC_ACTION || !handler) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
+    auto info = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
+    if(!info) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
+    if((info->flags & LLMHF_INJECTED) != 0) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
+
+    bool isDown = false;
+    int evVK = -1;
+    switch(wParam){
+        case WM_MOUSEWHEEL: {
+            // Wheel events carry no key; they reach the handler for recording
+            InputEvent ev;
+            ev.timeNs = clock->NowNs();
+            ev.vk = 0;
+            ev.down = false;
+            ev.wheel = static_cast<int16_t>(HIWORD(info->mouseData));
+            if(ev.wheel && handler->OnInput(ev)) return 1;
+            return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
+        }
+        case WM_LBUTTONDOWN: isDown = true; evVK = VK_LBUTTON; break;
+        case WM_LBUTTONUP:   isDown = false; evVK = VK_LBUTTON; break;
+        case WM_RBUTTONDOWN: isDown = true; evVK = VK_RBUTTON; break;
+        case WM_RBUTTONUP:   isDown = false; evVK = VK_RBUTTON; break;
+        case WM_MBUTTONDOWN: isDown = true; evVK = VK_MBUTTON; break;
+        case WM_MBUTTONUP:   isDown = false; evVK = VK_MBUTTON; break;
+        case WM_XBUTTONDOWN:
+        case WM_XBUTTONUP: {
+            WORD hi = HIWORD(info->mouseData);
+            if(hi == XBUTTON1) evVK = VK_XBUTTON1;
+            else if(hi == XBUTTON2) evVK = VK_XBUTTON2;
+            isDown = (wParam == WM_XBUTTONDOWN);
+            break;
+        }
+        default:
+            break;
+    }
+
+    if(evVK == -1) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
+
+    InputEvent ev;
+    ev.timeNs = clock->NowNs();
+    ev.vk = static_cast<uint8_t>(evVK);
+    ev.down = isDown;
+    if(handler->OnInput(ev)) return 1;
+    return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
+}
+
+// ---- Raw Input ----
+bool Win32RawInputSource::Start(IInputHandler *h){
+    if(thread.joinable()) return false;
+    handler = h;
+    filters.clear();
+    for(const auto &d : devices) filters.push_back(toLowerStr(d));
+    accepted.clear();
+    HANDLE ready = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    thread = std::thread(&Win32RawInputSource::Run, this, ready);
+    WaitForSingleObject(ready, INFINITE);
+    CloseHandle(ready);
+    if(!registered){
+        thread.join();
+        handler = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void Win32RawInputSource::Stop(){
+    if(!thread.joinable()) return;
+    if(window) PostMessageW(window, WM_CLOSE, 0, 0);
+    thread.join();
+    handler = nullptr;
+}
+
+void Win32RawInputSource::Run(HANDLE ready){
+    HINSTANCE instance = GetModuleHandleW(nullptr);
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = WndProc;
+    wc.hInstance = instance;
+    wc.lpszClassName = L"UniMacroRawInput";
+    RegisterClassW(&wc);
+    window = CreateWindowExW(0, wc.lpszClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, instance, this);
+
+    // Generic desktop keyboard and mouse, delivered whether or not we are in the foreground
+    RAWINPUTDEVICE rid[2] = {};
+    rid[0].usUsagePage = 0x01; rid[0].usUsage = 0x06;
+    rid[1].usUsagePage = 0x01; rid[1].usUsage = 0x02;
+    for(auto &r : rid){
+        r.dwFlags = RIDEV_INPUTSINK | RIDEV_DEVNOTIFY;
+        r.hwndTarget = window;
+    }
+    registered = window && RegisterRawInputDevices(rid, 2, sizeof(RAWINPUTDEVICE));
+    SetEvent(ready);
+    if(!registered){
+        if(window) DestroyWindow(window);
+        window = nullptr;
+        return;
+    }
+
+    MSG msg;
+    while(GetMessageW(&msg, nullptr, 0, 0) > 0) DispatchMessageW(&msg);
+
+    for(auto &r : rid){
+        r.dwFlags = RIDEV_REMOVE;
+        r.hwndTarget = nullptr;
+    }
+    RegisterRawInputDevices(rid, 2, sizeof(RAWINPUTDEVICE));
+    registered = false;
+    window = nullptr;
+}
+
+LRESULT CALLBACK Win32RawInputSource::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam){
+    if(msg == WM_NCCREATE){
+        auto cs = reinterpret_cast<CREATESTRUCTW*>(lParam);
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(cs->lpCreateParams));
+    }
+    auto self = reinterpret_cast<Win32RawInputSource*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    switch(msg){
+        case WM_INPUT:
+            if(self) self->OnRawInput(reinterpret_cast<HRAWINPUT>(lParam));
+            break;  // DefWindowProc still has to release the input
+        case WM_INPUT_DEVICE_CHANGE:
+            // Handles are reused once a device is gone, so its verdict goes with it
+            if(self && wParam == GIDC_REMOVAL) self->accepted.erase(reinterpret_cast<HANDLE>(lParam));
+            return 0;
+        case WM_DESTROY:
+            PostQuitMessage(0);
+            return 0;
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+bool Win32RawInputSource::Accepts(HANDLE device){
+    if(filters.empty()) return true;
+    auto it = accepted.find(device);
+    if(it != accepted.end()) return it->second;
+    bool ok = false;
+    UINT chars = 0;
+    GetRawInputDeviceInfoW(device, RIDI_DEVICENAME, nullptr, &chars);
+    if(chars > 0){
+        std::wstring wname(chars, L'\0');
+        if(GetRawInputDeviceInfoW(device, RIDI_DEVICENAME, &wname[0], &chars) != static_cast<UINT>(-1)){
+            // Interface names are plain ASCII ("\\?\HID#VID_046D&PID_C52B&MI_00#...")
+            std::string name;
+            for(wchar_t c : wname) if(c) name += static_cast<char>(c);
+            name = toLowerStr(name);
+            for(const auto &f : filters) ok = ok || name.find(f) != std::string::npos;
+        }
+    }
+    accepted.emplace(device, ok);
+    return ok;
+}
+
+void Win32RawInputSource::OnRawInput(HRAWINPUT input){
+    RAWINPUT raw;
+    UINT size = sizeof(raw);
+    if(GetRawInputData(input, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1)) return;
+    // SendInput events, ours included, come from no device
+    if(!raw.header.hDevice || !Accepts(raw.header.hDevice)) return;
+
+    if(raw.header.dwType == RIM_TYPEKEYBOARD){
+        const RAWKEYBOARD &k = raw.data.keyboard;
+        // 0xFF marks the fake keys of escaped scan code sequences
+        if(k.VKey == 0 || k.VKey >= 0xFF) return;
+        bool e0 = (k.Flags & RI_KEY_E0) != 0;
+        UINT vk = k.VKey;
+        // Raw Input reports the generic modifiers; the engine expects the sided VKs the hooks give
+        if(vk == VK_SHIFT) vk = MapVirtualKeyW(k.MakeCode, MAPVK_VSC_TO_VK_EX);
+        else if(vk == VK_CONTROL) vk = e0 ? VK_RCONTROL : VK_LCONTROL;
+        else if(vk == VK_MENU) vk = e0 ? VK_RMENU : VK_LMENU;
+        Dispatch(vk, (k.Flags & RI_KEY_BREAK) == 0);
+    } else if(raw.header.dwType == RIM_TYPEMOUSE){
+        // One report can carry several button transitions
+        static const struct { USHORT down, up; UINT vk; } kButtons[] = {
+            { RI_MOUSE_LEFT_BUTTON_DOWN,   RI_MOUSE_LEFT_BUTTON_UP,   VK_LBUTTON },
+            { RI_MOUSE_RIGHT_BUTTON_DOWN,  RI_MOUSE_RIGHT_BUTTON_UP,  VK_RBUTTON },
+            { RI_MOUSE_MIDDLE_BUTTON_DOWN, RI_MOUSE_MIDDLE_BUTTON_UP, VK_MBUTTON },
+            { RI_MOUSE_BUTTON_4_DOWN,      RI_MOUSE_BUTTON_4_UP,      VK_XBUTTON1 },
+            { RI_MOUSE_BUTTON_5_DOWN,      RI_MOUSE_BUTTON_5_UP,      VK_XBUTTON2 },
+        };
+        USHORT flags = raw.data.mouse.usButtonFlags;
+        for(const auto &b : kButtons){
+            if(flags & b.down) Dispatch(b.vk, true);
+            if(flags & b.up) Dispatch(b.vk, false);
+        }
+        if((flags & RI_MOUSE_WHEEL) && handler){
+            InputEvent ev;
+            ev.timeNs = clock.NowNs();
+            ev.vk = 0;
+            ev.down = false;
+            ev.wheel = static_cast<SHORT>(raw.data.mouse.usButtonData);
+            if(ev.wheel) handler->OnInput(ev);
+        }
+    }
+}
+
+// Same dispatch as the hooks; the suppress answer has nowhere to go
+void Win32RawInputSource::Dispatch(UINT vk, bool down){
+    if(!handler || vk == 0 || vk > 0xFF) return;
+    InputEvent ev;
+    ev.timeNs = clock.NowNs();
+    ev.vk = static_cast<uint8_t>(vk);
+    ev.down = down;
+    handler->OnInput(ev);
+}
+
+// ---- Thread tuning ----
+// The MMCSS task handle belongs to the thread that joined the task
+static thread_local HANDLE mmcssTask = nullptr;
+
+bool Win32ThreadTuner::Apply(const ThreadPolicy &policy){
+    HANDLE self = GetCurrentThread();
+    bool ok = true;
+    if(policy.priority == ThreadPolicy::NORMAL){
+        if(mmcssTask){
+            AvRevertMmThreadCharacteristics(mmcssTask);
+            mmcssTask = nullptr;
+        }
+        ok = SetThreadPriority(self, THREAD_PRIORITY_NORMAL) != FALSE;
+    } else {
+        bool realtime = policy.priority == ThreadPolicy::REALTIME;
+        if(!mmcssTask){
+            DWORD taskIndex = 0;
+            mmcssTask = AvSetMmThreadCharacteristicsW(L"Games", &taskIndex);
+        }
+        if(mmcssTask) ok = AvSetMmThreadPriority(mmcssTask, realtime ? AVRT_PRIORITY_CRITICAL : AVRT_PRIORITY_HIGH) != FALSE;
+        else ok = SetThreadPriority(self, realtime ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST) != FALSE;
+    }
+
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if(!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) return false;
+    DWORD_PTR mask = policy.cores ? static_cast<DWORD_PTR>(policy.cores) & processMask : processMask;
+    if(mask == 0 || SetThreadAffinityMask(self, mask) == 0) ok = false;
+    return ok;
+}
+
+// ---- SendInput sink ----
+// The whole batch goes out in a single SendInput so it is injected atomically and
+// costs one kernel transition. Binds are injected on the worker along with everything
+// else, so only the worker thread calls this and the buffer needs no guarding.
+void Win32InputSink::Send(const InjectOp *ops, size_t count){
+    if(count == 0) return;
+    buffer.assign(count, INPUT{});
+    for(size_t i = 0; i < count; ++i){
+        const InjectOp &op = ops[i];
+        if(op.type == InjectOp::KEY){
+            buffer[i].type = INPUT_KEYBOARD;
+            buffer[i].ki.wVk = op.vk;
+            buffer[i].ki.dwFlags = op.flags;
+        } else {
+            buffer[i].type = INPUT_MOUSE;
+            buffer[i].mi.dwFlags = op.flags;
+            buffer[i].mi.mouseData = static_cast<DWORD>(op.mouseData);
+        }
+    }
+    SendInput(static_cast<UINT>(count), buffer.data(), sizeof(INPUT));
+}
+
+// ---- Waitable timer clock ----
+Win32Clock::Win32Clock(){
+    QueryPerformanceFrequency(&qpcFrequency);
+    // High-resolution timers need Windows 10 1803+; older systems fall back to a
+    // regular waitable timer, which timeBeginPeriod(1) keeps at 1 ms granularity.
+    timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if(!timer) timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    timeBeginPeriod(1);
+}
+
+Win32Clock::~Win32Clock(){
+    if(timer) CloseHandle(timer);
+    if(wakeEvent) CloseHandle(wakeEvent);
+    timeEndPeriod(1);
+}
+
+uint64_t Win32Clock::NowNs(){
+    LARGE_INTEGER c;
+    QueryPerformanceCounter(&c);
+    uint64_t ticks = static_cast<uint64_t>(c.QuadPart);
+    uint64_t freq = static_cast<uint64_t>(qpcFrequency.QuadPart);
+    return (ticks / freq) * 1000000000ull + (ticks % freq) * 1000000000ull / freq;
+}
+
+void Win32Clock::SleepNs(uint64_t ns){
+    Sleep(static_cast<DWORD>(ns / 1000000ull));
+}
+
+void Win32Clock::WaitUntil(uint64_t deadlineNs){
+    if(deadlineNs == kForever){
+        WaitForSingleObject(wakeEvent, INFINITE);
+        return;
+    }
+    uint64_t now = NowNs();
+    if(deadlineNs <= now) return;
+    // Waitable timers take a relative due time as a negative count of 100 ns units
+    LARGE_INTEGER due;
+    due.QuadPart = -static_cast<LONGLONG>((deadlineNs - now + 99) / 100);
+    SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE);
+    HANDLE handles[2] = { wakeEvent, timer };
+    WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+}
+
+void Win32Clock::Wake(){
+    SetEvent(wakeEvent);
+}
+
+// ---- Directory watcher ----
+// Debounce times only need millisecond resolution, so the tick count is enough here
+static uint64_t TickNs(){
+    return GetTickCount64() * 1000000ull;
+}
+
+Win32DirWatcher::~Win32DirWatcher(){
+    Stop();
+}
+
+bool Win32DirWatcher::Start(const std::string &dir, ChangeFn fn){
+    if(thread.joinable()) return false;
+    std::wstring wdir(dir.begin(), dir.end());
+    dirHandle = CreateFileW(wdir.c_str(), FILE_LIST_DIRECTORY,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                            OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if(dirHandle == INVALID_HANDLE_VALUE) return false;
+    stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    onChanged = fn;
+    thread = std::thread(&Win32DirWatcher::Run, this);
+    return true;
+}
+
+void Win32DirWatcher::Stop(){
+    if(!thread.joinable()) return;
+    SetEvent(stopEvent);
+    thread.join();
+    CloseHandle(dirHandle);
+    CloseHandle(stopEvent);
+    dirHandle = INVALID_HANDLE_VALUE;
+    stopEvent = nullptr;
+}
+
+void Win32DirWatcher::Run(){
+    Debouncer debounce(debounceNs);
+    alignas(DWORD) BYTE buf[8192];
+    OVERLAPPED ov = {};
+    ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+    bool armed = false;
+    for(;;){
+        if(!armed){
+            ResetEvent(ov.hEvent);
+            if(!ReadDirectoryChangesW(dirHandle, buf, sizeof(buf), FALSE, filter, NULL, &ov, NULL)) break;
+            armed = true;
+        }
+        uint64_t due = debounce.NextDueNs();
+        DWORD timeoutMs = INFINITE;
+        if(due != Debouncer::kNone){
+            uint64_t now = TickNs();
+            timeoutMs = due > now ? static_cast<DWORD>((due - now + 999999) / 1000000) : 0;
+        }
+        HANDLE handles[2] = { stopEvent, ov.hEvent };
+        DWORD r = WaitForMultipleObjects(2, handles, FALSE, timeoutMs);
+        if(r == WAIT_OBJECT_0) break;
+        if(r == WAIT_OBJECT_0 + 1){
+            armed = false;
+            DWORD bytes = 0;
+            // Zero bytes means the buffer overflowed; nothing to name, so the next edit catches up
+            if(GetOverlappedResult(dirHandle, &ov, &bytes, FALSE) && bytes > 0){
+                uint64_t now = TickNs();
+                for(BYTE *p = buf;;){
+                    const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+                    std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                    debounce.Touch(std::string(name.begin(), name.end()), now);
+                    if(info->NextEntryOffset == 0) break;
+                    p += info->NextEntryOffset;
+                }
+            }
+        }
+        debounce.Flush(TickNs(), onChanged);
+    }
+    if(armed){
+        CancelIo(dirHandle);
+        DWORD bytes = 0;
+        GetOverlappedResult(dirHandle, &ov, &bytes, TRUE);
+    }
+    CloseHandle(ov.hEvent);
+}
+
+// ---- Foreground watcher ----
+Win32ForegroundWatcher::ChangeFn Win32ForegroundWatcher::onChanged;
+HWINEVENTHOOK Win32ForegroundWatcher::hook = nullptr;
+
+Win32ForegroundWatcher::~Win32ForegroundWatcher(){
+    Stop();
+}
+
+bool Win32ForegroundWatcher::Start(ChangeFn fn){
+    if(hook) return false;
+    onChanged = fn;
+    hook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, NULL, WinEventProc, 0, 0,
+                           WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    return hook != nullptr;
+}
+
+void Win32ForegroundWatcher::Stop(){
+    if(hook) { UnhookWinEvent(hook); hook = nullptr; }
+    onChanged = nullptr;
+}
+
+void Win32ForegroundWatcher::Poll(){
+    Report(GetForegroundWindow());
+}
+
+void CALLBACK Win32ForegroundWatcher::WinEventProc(HWINEVENTHOOK, DWORD, HWND hwnd, LONG idObject,
+                                                   LONG, DWORD, DWORD){
+    if(idObject == OBJID_WINDOW) Report(hwnd);
+}
+
+// One process query and one class lookup per focus change; nothing is polled
+void Win32ForegroundWatcher::Report(HWND hwnd){
+    if(!hwnd || !onChanged) return;
+    WCHAR className[256] = {};
+    GetClassNameW(hwnd, className, 256);
+    std::wstring exe;
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    if(HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid)){
+        WCHAR path[MAX_PATH];
+        DWORD length = MAX_PATH;
+        if(QueryFullProcessImageNameW(process, 0, path, &length)){
+            exe.assign(path, length);
+            size_t slash = exe.find_last_of(L"\\/");
+            if(slash != std::wstring::npos) exe.erase(0, slash + 1);
+        }
+        CloseHandle(process);
+    }
+    std::wstring cls(className);
+    onChanged(std::string(exe.begin(), exe.end()), std::string(cls.begin(), cls.end()));
+}
+
+// ---- Mapped file ----
+bool Win32MappedFile::Open(const std::string &path){
+    Close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0){
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(!mapping) return false;
+    void *p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(!p) return false;
+    data = static_cast<const uint8_t*>(p);
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void Win32MappedFile::Close(){
+    if(data) UnmapViewOfFile(data);
+    data = nullptr;
+    size = 0;
+}
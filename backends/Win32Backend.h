@@ -0,0 +1,159 @@
+#pragma once
+#include <windows.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Backend.h"
+
+// ---- Win32 backend ----
+// Low-level keyboard/mouse hooks as the input source, SendInput as the sink and a
+// QPC clock that sleeps on a high-resolution waitable timer. The hooks are process-global, so only one
+// Win32HookSource may be started at a time; they run on a thread of their own so the
+// tray and console never hold up a hook call. Win32RawInputSource is the hook-free
+// alternative for profiles that need not block their triggers. Win32DirWatcher reports profile edits through
+// ReadDirectoryChangesW, Win32ForegroundWatcher follows the foreground window through
+// SetWinEventHook and Win32MappedFile maps compiled profiles.
+
+class Win32HookSource : public IInputSource {
+public:
+    explicit Win32HookSource(IClock &clock) { Win32HookSource::clock = &clock; }
+    ~Win32HookSource(){ Stop(); }
+    bool Start(IInputHandler *handler) override;
+    void Stop() override;
+
+private:
+    static LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
+    static LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam);
+    void Run(HANDLE ready);
+
+    std::thread thread;
+    DWORD threadId = 0;
+    bool installed = false;
+
+    static IInputHandler *handler;
+    static IClock *clock;
+    static HHOOK gKeyboardHook;
+    static HHOOK gMouseHook;
+};
+
+// Raw Input (WM_INPUT, RIDEV_INPUTSINK) read on a message-only window of its own
+// thread. Unlike the hooks it sits in no other process's input path and has no hook
+// timeout to miss, but it cannot block input: the handler's suppress answer is ignored
+// and every trigger also reaches the foreground application. Raw Input registration is
+// per process, so one instance at a time.
+class Win32RawInputSource : public IInputSource {
+public:
+    explicit Win32RawInputSource(IClock &clock) : clock(clock) {}
+    ~Win32RawInputSource(){ Stop(); }
+    bool Start(IInputHandler *handler) override;
+    void Stop() override;
+
+    // When not empty, only devices whose interface name contains one of these
+    // (case-insensitive, e.g. "VID_046D&PID_C52B") are listened to. Set before Start.
+    std::vector<std::string> devices;
+
+private:
+    static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+    void Run(HANDLE ready);
+    void OnRawInput(HRAWINPUT input);
+    bool Accepts(HANDLE device);
+    void Dispatch(UINT vk, bool down);
+
+    IClock &clock;
+    IInputHandler *handler = nullptr;
+    HWND window = nullptr;
+    bool registered = false;
+    std::vector<std::string> filters;
+    // Filter verdict per device handle, settled on the device's first event
+    std::unordered_map<HANDLE, bool> accepted;
+    std::thread thread;
+};
+
+// Joins the calling thread to the MMCSS "Games" task, which schedules it in the
+// multimedia class's raised range without administrator rights, and falls back to
+// SetThreadPriority where the service is off. Cores outside the process mask are dropped.
+class Win32ThreadTuner : public IThreadTuner {
+public:
+    bool Apply(const ThreadPolicy &policy) override;
+};
+
+class Win32InputSink : public IInputSink {
+public:
+    void Send(const InjectOp *ops, size_t count) override;
+
+private:
+    std::vector<INPUT> buffer;
+};
+
+class Win32Clock : public IClock {
+public:
+    Win32Clock();
+    ~Win32Clock();
+    uint64_t NowNs() override;
+    void SleepNs(uint64_t ns) override;
+    void WaitUntil(uint64_t deadlineNs) override;
+    void Wake() override;
+
+private:
+    LARGE_INTEGER qpcFrequency;
+    HANDLE timer = nullptr;
+    HANDLE wakeEvent = nullptr;
+};
+
+class Win32DirWatcher : public IFileWatcher {
+public:
+    ~Win32DirWatcher();
+    bool Start(const std::string &dir, ChangeFn onChanged) override;
+    void Stop() override;
+
+    // Quiet time after the last write before a file is reported
+    uint64_t debounceNs = 250000000;
+
+private:
+    void Run();
+
+    ChangeFn onChanged;
+    HANDLE dirHandle = INVALID_HANDLE_VALUE;
+    HANDLE stopEvent = nullptr;
+    std::thread thread;
+};
+
+// EVENT_SYSTEM_FOREGROUND, delivered out of context to the thread that called Start,
+// which must run a message loop. Process-global like the hooks: one instance at a time.
+class Win32ForegroundWatcher : public IForegroundWatcher {
+public:
+    ~Win32ForegroundWatcher();
+    bool Start(ChangeFn onChanged) override;
+    void Stop() override;
+
+    // Reports the window that is in the foreground right now
+    void Poll();
+
+private:
+    static void CALLBACK WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject,
+                                      LONG idChild, DWORD eventThread, DWORD eventTime);
+    static void Report(HWND hwnd);
+
+    static ChangeFn onChanged;
+    static HWINEVENTHOOK hook;
+};
+
+// Read-only mapping of a whole file
+class Win32MappedFile {
+public:
+    Win32MappedFile() = default;
+    Win32MappedFile(const Win32MappedFile&) = delete;
+    Win32MappedFile& operator=(const Win32MappedFile&) = delete;
+    ~Win32MappedFile(){ Close(); }
+
+    bool Open(const std::string &path);
+    void Close();
+    const uint8_t *Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+};
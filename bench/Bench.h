@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+// ---- Benchmark suites ----
+// Each suite prints its own table and records the numbers worth comparing between
+// builds through BenchRecord; unimacro_bench writes the records out as JSON or CSV.
+// A suite returns non-zero when a correctness check it runs along the way fails.
+void BenchRecord(const char *suite, const std::string &variant, const char *metric, double value, const char *unit);
+
+int BenchDispatch();
+int BenchInject();
+int BenchParse();
+int BenchKeyMap();
+int BenchProfileLoad();
+int BenchEngine();
+int BenchScheduler();
+int BenchHook();
+int BenchReload();
+int BenchContention();
+int BenchReplay();
+int BenchPriority();
+int BenchBudget();
+int BenchWheel();
+#if !defined(_WIN32)
+int BenchEvdev();
+#endif
+
+// Config folder of the source tree, for suites that read the sample profiles
+#ifndef UNIMACRO_CFG_DIR
+#define UNIMACRO_CFG_DIR "CFG"
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+// Real-time clock, file mapping and thread tuning of the host, for the suites that run on wall time
+#if defined(_WIN32)
+#include "Win32Backend.h"
+typedef Win32Clock BenchClock;
+typedef Win32MappedFile BenchMappedFile;
+typedef Win32ThreadTuner BenchThreadTuner;
+#else
+#include "LinuxBackend.h"
+typedef LinuxClock BenchClock;
+typedef LinuxMappedFile BenchMappedFile;
+typedef LinuxThreadTuner BenchThreadTuner;
+#endif
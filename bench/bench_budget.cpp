@@ -0,0 +1,105 @@
+// Injection budget on the virtual clock: three autoclickers far over a [Budget] and one
+// well under it, while a bind is tapped every 10 ms. Checks that the total stays within
+// the budget, that the fast clickers split what the slow one leaves evenly, that the
+// slow one is never throttled and that every bind press goes out the instant it happens.
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "Bench.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+
+static const char *kBudgetMacros =
+    "[AutoClick] [TOGGLE] \"f6\" \"lmb\" [0.1]\n"
+    "[AutoClick] [TOGGLE] \"f7\" \"rmb\" [0.1]\n"
+    "[AutoClick] [TOGGLE] \"f8\" \"mmb\" [0.25]\n"
+    "[AutoClick] [TOGGLE] \"f9\" \"lmb\" [50]\n"
+    "[Bind] \"b\" \"c\"\n";
+
+static int RunBudget(const KeyMap &keys, uint32_t budget){
+    SimClock clock;
+    SimInputSink sink(clock);
+    SimInputSource source(clock);
+    Engine engine(sink, clock);
+    std::string text = (budget ? "[Budget] \"" + std::to_string(budget) + "\"\n" : std::string()) + kBudgetMacros;
+    std::istringstream in(text);
+    Profile *p = new Profile();
+    ParseMacros(in, keys, *p);
+    engine.SetProfile(p);
+    source.Start(&engine);
+
+    clock.AdvanceTo(1000000000ull);
+    for(int f = 5; f <= 8; ++f){
+        source.Feed(static_cast<uint8_t>(kVkF1 + f), true);
+        source.Feed(static_cast<uint8_t>(kVkF1 + f), false);
+    }
+    RunEngineUntil(engine, clock, clock.NowNs() + 100000000ull);
+
+    // 2 s of bind taps, a press every 10 ms held for 5 ms
+    const uint64_t kRunNs = 2000000000ull;
+    uint64_t start = clock.NowNs();
+    size_t sentBefore = sink.records.size();
+    uint64_t clicksBefore[4];
+    for(int i = 0; i < 4; ++i) clicksBefore[i] = p->macros[i]->stats.clicks.load();
+    size_t presses = 0, onTime = 0;
+    for(uint64_t t = start; t < start + kRunNs; t += 10000000ull){
+        RunEngineUntil(engine, clock, t);
+        size_t before = sink.records.size();
+        source.Feed('B', true);
+        RunEngineUntil(engine, clock, t + 5000000ull);
+        ++presses;
+        for(size_t r = before; r < sink.records.size(); ++r){
+            const InjectOp &op = sink.records[r].op;
+            if(op.type == InjectOp::KEY && op.vk == 'C' && (op.flags & kKeyEventUp) == 0){
+                onTime += sink.records[r].timeNs == t;
+                break;
+            }
+        }
+        source.Feed('B', false);
+    }
+    RunEngineUntil(engine, clock, start + kRunNs);
+    double seconds = kRunNs / 1e9;
+    double rate = double(sink.records.size() - sentBefore) / seconds;
+
+    double cps[4];
+    for(int i = 0; i < 4; ++i) cps[i] = double(p->macros[i]->stats.clicks.load() - clicksBefore[i]) / seconds;
+    const char *variant = budget ? "budget" : "unlimited";
+    std::printf("%10s %8u %10.0f %8zu/%-4zu %9.0f %9.0f %9.0f %9.0f %10llu\n", variant, budget, rate, onTime, presses,
+                cps[0], cps[1], cps[2], cps[3], (unsigned long long)engine.throttledClicks.load());
+    BenchRecord("budget", variant, "events", rate, "events/s");
+    BenchRecord("budget", variant, "bind_on_time", double(onTime) / double(presses), "fraction");
+
+    int failed = 0;
+    if(onTime != presses){
+        std::printf("FAIL: %zu of %zu bind presses were held back\n", presses - onTime, presses);
+        ++failed;
+    }
+    if(!budget) return failed;
+    // One catch-up window of burst on top of the rate
+    if(rate > budget * 1.01 + 10){
+        std::printf("FAIL: %.0f events/s sent over a budget of %u\n", rate, budget);
+        ++failed;
+    }
+    if(p->macros[3]->stats.throttled.load() != 0){
+        std::printf("FAIL: the autoclicker under its share was throttled\n");
+        ++failed;
+    }
+    double low = std::min({ cps[0], cps[1], cps[2] }), high = std::max({ cps[0], cps[1], cps[2] });
+    if(low < high * 0.9){
+        std::printf("FAIL: uneven split, %.0f to %.0f clicks/s\n", low, high);
+        ++failed;
+    }
+    return failed;
+}
+
+int BenchBudget(){
+    KeyMap keys;
+    std::printf("%10s %8s %10s %13s %9s %9s %9s %9s %10s\n", "variant", "budget", "events/s", "bind on time",
+                "0.1 ms", "0.1 ms", "0.25 ms", "50 ms", "throttled");
+    int failed = RunBudget(keys, 0);
+    failed += RunBudget(keys, 4000);
+    return failed;
+}
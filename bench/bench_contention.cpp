@@ -0,0 +1,196 @@
+// Macro state under contention. First the layout alone: worker threads update the
+// scheduling state of their macros while a hook thread reads the config of every
+// macro, once with the fields packed together as they used to be and once in the
+// profile arena's line-separated layout. Then the engine itself with many autoclickers
+// running on the real clock while input hits their triggers.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "BenchPlatform.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+
+class CountingSink : public IInputSink {
+public:
+    void Send(const InjectOp *, size_t count) override { sent += count; }
+    uint64_t sent = 0;
+};
+
+// The fields the hook and worker touch, in one unpadded block per macro and the
+// blocks back to back: config, flags and scheduler state all share lines
+struct PackedMacro {
+    uint32_t triggerCfg = 0;
+    bool keepOriginal = false;
+    bool dropOriginal = false;
+    KeySet chord;
+    std::atomic_bool active{false};
+    uint64_t nextDueNs = 0;
+    uint64_t periodNs = 1000000;
+    struct { std::atomic<uint64_t> fires{0}; } stats;
+};
+
+static volatile uint64_t sinkValue;
+
+// ---- Layout ----
+// Each worker owns a slice of the macros and advances their timelines; the reader
+// checks every macro the way OnInput checks the candidates for a chord key
+template <typename M>
+static void RunLayout(const char *layout, std::vector<M*> &macros, int workers){
+    const auto kDuration = std::chrono::milliseconds(300);
+    std::atomic_bool stop{false};
+    std::atomic<uint64_t> updates{0};
+    std::vector<std::thread> threads;
+    for(int w = 0; w < workers; ++w){
+        threads.emplace_back([&, w]{
+            uint64_t n = 0;
+            while(!stop.load(std::memory_order_relaxed)){
+                for(size_t i = w; i < macros.size(); i += workers){
+                    M *m = macros[i];
+                    m->nextDueNs += m->periodNs;
+                    m->stats.fires.fetch_add(1, std::memory_order_relaxed);
+                    m->active.store((m->nextDueNs & 1) == 0, std::memory_order_relaxed);
+                    ++n;
+                }
+            }
+            updates.fetch_add(n);
+        });
+    }
+    KeySet pressed;
+    pressed.Set(kVkLShift);
+    uint64_t reads = 0, matched = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    auto end = t0 + kDuration;
+    while(std::chrono::steady_clock::now() < end){
+        for(int pass = 0; pass < 64; ++pass){
+            for(const M *m : macros){
+                matched += pressed.Contains(m->chord) && !m->keepOriginal && m->triggerCfg != 0;
+            }
+            reads += macros.size();
+        }
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    stop.store(true);
+    for(auto &t : threads) t.join();
+
+    double readNs = elapsedNs / double(reads);
+    double updateRate = double(updates.load()) / (elapsedNs / 1e9) / 1e6;
+    std::string variant = std::string(layout) + ",macros=" + std::to_string(macros.size()) + ",workers=" + std::to_string(workers);
+    sinkValue = matched;
+    std::printf("%8s %8zu %8d %14.2f %16.1f\n", layout, macros.size(), workers, readNs, updateRate);
+    BenchRecord("contention", variant, "hook_read", readNs, "ns/macro");
+    BenchRecord("contention", variant, "worker_updates", updateRate, "M/s");
+}
+
+static void BenchLayout(){
+    std::printf("-- layout --\n%8s %8s %8s %14s %16s\n", "layout", "macros", "workers", "read ns/macro", "updates M/s");
+    unsigned cores = std::max(2u, std::thread::hardware_concurrency());
+    int workers = static_cast<int>(std::min(4u, cores - 1));
+    for(int n : { 8, 64 }){
+        std::vector<PackedMacro> packedStore(n);
+        std::vector<PackedMacro*> packed;
+        Profile profile;
+        for(int i = 0; i < n; ++i){
+            packedStore[i].triggerCfg = static_cast<uint32_t>('A' + i % 26);
+            packedStore[i].chord.Set(kVkLShift);
+            packed.push_back(&packedStore[i]);
+            Macro *m = profile.NewMacro();
+            m->triggerCfg = packedStore[i].triggerCfg;
+            m->chord.Set(kVkLShift);
+            m->periodNs = 1000000;
+        }
+        RunLayout("packed", packed, workers);
+        RunLayout("arena", profile.macros, workers);
+    }
+}
+
+// ---- Engine ----
+// count autoclickers at 1 ms on shift+<key> triggers, all toggled on, while the input
+// thread keeps pressing the bare keys: every press is a chord key the hook has to
+// check against its macro as the worker fires that macro
+static const char *kTriggers[] = {
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o", "p",
+    "q", "r", "s", "t", "u", "v", "w", "x", "y", "z", "0", "1", "2", "3", "4", "5",
+};
+
+static int BenchEngineContention(const KeyMap &keys){
+    std::printf("-- engine --\n%8s %10s %10s %10s %12s %12s %10s\n", "clickers", "hook p50", "hook p99", "hook max",
+                "late p99 us", "clicks/s", "expected");
+    int failed = 0;
+    for(int count : { 4, 16, 32 }){
+        BenchClock clock;
+        CountingSink sink;
+        SimInputSource source(clock);
+        Engine engine(sink, clock);
+        engine.catchUpNs = 5000000;
+        std::ostringstream ini;
+        for(int i = 0; i < count; ++i) ini << "[AutoClick] [TOGGLE] \"shift+" << kTriggers[i] << "\" \"f5\" [1]\n";
+        std::istringstream in(ini.str());
+        Profile *p = new Profile();
+        ParseMacros(in, keys, *p);
+        engine.SetProfile(p);
+        source.Start(&engine);
+        engine.Start();
+
+        std::vector<uint8_t> vks;
+        for(const Macro *m : p->macros) vks.push_back(static_cast<uint8_t>(MapConfigCodeToDetectVK(static_cast<int>(m->triggerCfg))));
+        source.Feed(kVkLShift, true);
+        for(uint8_t vk : vks){
+            source.Feed(vk, true);
+            source.Feed(vk, false);
+        }
+        source.Feed(kVkLShift, false);
+        clock.SleepNs(20000000);
+        engine.hookResidency.Reset();
+
+        const uint64_t kRunNs = 1000000000ull;
+        uint64_t start = clock.NowNs();
+        uint64_t clicksBefore = 0;
+        for(const Macro *m : p->macros) clicksBefore += m->stats.clicks.load();
+        for(size_t i = 0; clock.NowNs() - start < kRunNs; ++i){
+            uint8_t vk = vks[i % vks.size()];
+            source.Feed(vk, true);
+            source.Feed(vk, false);
+            if((i & 31) == 0) clock.SleepNs(200000);
+        }
+        uint64_t elapsed = clock.NowNs() - start;
+        engine.Stop();
+
+        uint64_t clicks = 0, lateP99 = 0;
+        bool allActive = true;
+        for(const Macro *m : p->macros){
+            clicks += m->stats.clicks.load();
+            lateP99 = std::max(lateP99, m->stats.lateness.Percentile(0.99));
+            allActive &= m->active.load();
+        }
+        clicks -= clicksBefore;
+        const LatencyHistogram &h = engine.hookResidency;
+        double rate = double(clicks) * 1e9 / double(elapsed);
+        std::printf("%8d %10.2f %10.2f %10.2f %12.1f %12.0f %10d\n", count, h.Percentile(0.50) / 1000.0,
+                    h.Percentile(0.99) / 1000.0, h.Max() / 1000.0, lateP99 / 1000.0, rate, count * 1000);
+        std::string variant = "clickers=" + std::to_string(count);
+        BenchRecord("contention", variant, "hook_p50", h.Percentile(0.50) / 1000.0, "us");
+        BenchRecord("contention", variant, "hook_p99", h.Percentile(0.99) / 1000.0, "us");
+        BenchRecord("contention", variant, "late_p99", lateP99 / 1000.0, "us");
+        BenchRecord("contention", variant, "clicks", rate, "clicks/s");
+        // Pressing the bare key must not toggle anything: the chord is not held
+        if(!allActive){
+            std::printf("FAIL: a chord autoclicker was toggled off by its bare key\n");
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+int BenchContention(){
+    KeyMap keys;
+    BenchLayout();
+    return BenchEngineContention(keys);
+}
@@ -0,0 +1,87 @@
+// Per-event hook dispatch cost versus macro count: the old linear scan over
+// every macro (MapConfigCodeToDetectVK per entry) against DispatchTable, and that a
+// table given more macros than it can index stays within its entries.
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "DispatchTable.h"
+#include "Profile.h"
+
+struct BenchMacro {
+    int triggerCfg;
+    int hits;
+};
+
+static const int kTriggerPool[] = {
+    253, 252, 4, 5, 6, 254, 255,
+    'A','B','C','D','E','F','G','Q','R','T','U','V','X','Y','Z',
+    0x20, 0x10, 0x11, 0x12, 0x70, 0x71, 0x72, 0x73, 0x74
+};
+
+static volatile int sink;
+
+int BenchDispatch(){
+    const size_t kEvents = 2000000;
+    const size_t counts[] = { 1, 4, 8, 16, 32, 64, 128, 256 };
+
+    std::mt19937 rng(1234);
+    // Input stream: mostly unbound keys, as on a normal keyboard/mouse session
+    std::vector<int> events(kEvents);
+    std::uniform_int_distribution<int> anyVK(1, 254);
+    for(auto &e : events) e = anyVK(rng);
+
+    std::printf("%8s %14s %14s %9s\n", "macros", "scan ns/ev", "table ns/ev", "speedup");
+    for(size_t n : counts){
+        std::vector<BenchMacro> macros(n);
+        std::uniform_int_distribution<size_t> pick(0, sizeof(kTriggerPool)/sizeof(kTriggerPool[0]) - 1);
+        for(auto &m : macros){ m.triggerCfg = kTriggerPool[pick(rng)]; m.hits = 0; }
+
+        std::vector<int> detect(n);
+        for(size_t i = 0; i < n; ++i) detect[i] = MapConfigCodeToDetectVK(macros[i].triggerCfg);
+        DispatchTable table;
+        table.Build(detect.data(), detect.size());
+
+        auto t0 = std::chrono::steady_clock::now();
+        for(int vk : events){
+            for(auto &m : macros){
+                int d = MapConfigCodeToDetectVK(m.triggerCfg);
+                if(d <= 0) continue;
+                if(d != vk) continue;
+                ++m.hits;
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for(int vk : events){
+            if(table.Empty(vk)) continue;
+            for(const DispatchEntry *e = table.First(vk), *end = table.Last(vk); e != end; ++e){
+                ++macros[e->macroIndex].hits;
+            }
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        int total = 0;
+        for(auto &m : macros) total += m.hits;
+        sink = total;
+
+        double scanNs  = std::chrono::duration<double, std::nano>(t1 - t0).count() / kEvents;
+        double tableNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / kEvents;
+        std::printf("%8zu %14.2f %14.2f %8.1fx\n", n, scanNs, tableNs, scanNs / tableNs);
+        std::string variant = "macros=" + std::to_string(n);
+        BenchRecord("dispatch", variant, "scan", scanNs, "ns/event");
+        BenchRecord("dispatch", variant, "table", tableNs, "ns/event");
+    }
+
+    // More macros on one key than the 16-bit offsets hold: the rest are left out, not wrapped
+    std::vector<int> crowded(70000, 'Q');
+    DispatchTable table;
+    table.Build(crowded.data(), crowded.size());
+    bool capped = table.entries.size() == DispatchTable::kMaxEntries
+               && table.Last('Q') - table.First('Q') == static_cast<ptrdiff_t>(DispatchTable::kMaxEntries);
+    std::printf("70000 macros on one key: %zu dispatched%s\n", table.entries.size(), capped ? "" : "  FAIL");
+    return capped ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// Engine throughput on the simulated backend: hook-path cost per input event and
+// timer-path cost per delivered click, both measured in wall time while the engine
+// itself runs on the virtual clock.
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "Bench.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+
+// chord is prefixed to every bind trigger, e.g. "ctrl+" to make them all chords
+static std::string MakeProfile(int autoclickers, int binds, float intervalMs, const char *chord = ""){
+    static const char *triggers[] = { "mouse4", "mouse5", "q", "e", "r", "t", "y", "u", "i", "o", "p", "z", "x", "c", "v", "b" };
+    static const char *targets[]  = { "lmb", "rmb", "f5", "space", "mousewheel_down", "k", "l", "j" };
+    std::ostringstream out;
+    for(int i = 0; i < autoclickers; ++i){
+        out << "[AutoClick] [HOLD] [K] \"" << triggers[i % 16] << "\" \"" << targets[i % 8] << "\" [" << intervalMs << "]\n";
+    }
+    for(int i = 0; i < binds; ++i){
+        out << "[Bind] [K] \"" << chord << triggers[(i + 7) % 16] << "\" \"" << targets[(i + 3) % 8] << "\"\n";
+    }
+    return out.str();
+}
+
+// Input side split in two: OnInput as called from the hook, and the worker draining
+// the ring (macro state updates, bind injection) in batches of 256 events. The chord
+// rows make every bind a ctrl+shift chord, which the hook has to match per press.
+static void BenchInputPath(const KeyMap &keys){
+    std::printf("-- input path --\n%8s %7s %14s %16s %12s\n", "macros", "chords", "hook ns/ev", "worker ns/ev", "suppressed");
+    const int kEvents = 1000000;
+    const int kChunk = 256;
+    for(bool chords : { false, true })
+    for(int n : { 1, 8, 32, 64 }){
+        SimClock clock;
+        SimInputSink sink(clock);
+        SimInputSource source(clock);
+        Engine engine(sink, clock);
+        std::istringstream in(MakeProfile(n / 2, n - n / 2, 10.0f, chords ? "ctrl+shift+" : ""));
+        Profile *p = new Profile();
+        ParseMacros(in, keys, *p);
+        engine.SetProfile(p);
+        source.Start(&engine);
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> anyVK(1, 254);
+        double hookNs = 0, workerNs = 0;
+        for(int done = 0; done < kEvents; done += kChunk){
+            auto t0 = std::chrono::steady_clock::now();
+            for(int i = 0; i < kChunk / 2; ++i){
+                int vk = anyVK(rng);
+                source.Feed(static_cast<uint8_t>(vk), true);
+                source.Feed(static_cast<uint8_t>(vk), false);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            engine.RunDue(clock.NowNs());
+            auto t2 = std::chrono::steady_clock::now();
+            hookNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            workerNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+            sink.Clear();
+        }
+        std::printf("%8d %7s %14.2f %16.2f %12llu\n", n, chords ? "yes" : "no", hookNs / kEvents, workerNs / kEvents,
+                    (unsigned long long)source.suppressed);
+        std::string variant = "macros=" + std::to_string(n) + (chords ? ",chords" : "");
+        BenchRecord("engine", variant, "hook", hookNs / kEvents, "ns/event");
+        BenchRecord("engine", variant, "worker", workerNs / kEvents, "ns/event");
+    }
+}
+
+static void BenchTimerPath(const KeyMap &keys){
+    std::printf("-- timer path (10 s virtual) --\n%8s %10s %12s %14s %14s\n", "active", "interval", "injected", "ns/click", "send calls");
+    const uint64_t kRunNs = 10ull * 1000000000ull;
+    for(int n : { 1, 4, 10 }){
+        for(float interval : { 0.5f, 1.0f, 10.0f }){
+            SimClock clock;
+            SimInputSink sink(clock);
+            SimInputSource source(clock);
+            Engine engine(sink, clock);
+            std::istringstream in(MakeProfile(n, 0, interval));
+            Profile *p = new Profile();
+            ParseMacros(in, keys, *p);
+            engine.SetProfile(p);
+            source.Start(&engine);
+            for(const auto m : p->macros) source.Feed(static_cast<uint8_t>(MapConfigCodeToDetectVK((int)m->triggerCfg)), true);
+            sink.records.reserve(1 << 20);
+
+            auto t0 = std::chrono::steady_clock::now();
+            RunEngineUntil(engine, clock, kRunNs);
+            auto t1 = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (sink.records.empty() ? 1 : sink.records.size());
+            std::printf("%8d %10.2f %12zu %14.2f %14llu\n", n, interval, sink.records.size(), ns, (unsigned long long)sink.sendCalls);
+            char variant[48];
+            std::snprintf(variant, sizeof(variant), "active=%d,interval=%g", n, interval);
+            BenchRecord("engine", variant, "timer", ns, "ns/click");
+            BenchRecord("engine", variant, "send_calls", double(sink.sendCalls), "calls");
+        }
+    }
+}
+
+// Many looping [Sequence] macros running at once, cost per key press or click step
+static void BenchSequencePath(const KeyMap &keys){
+    static const char *triggers[] = { "mouse4", "mouse5", "q", "e", "r", "t", "y", "u", "i", "o", "p", "z", "x", "c", "v", "b" };
+    std::printf("-- sequence path (10 s virtual) --\n%8s %12s %14s %14s\n", "running", "presses", "ns/press", "send calls");
+    const uint64_t kRunNs = 10ull * 1000000000ull;
+    for(int n : { 1, 16, 64 }){
+        SimClock clock;
+        SimInputSink sink(clock);
+        SimInputSource source(clock);
+        Engine engine(sink, clock);
+        std::ostringstream text;
+        for(int i = 0; i < n; ++i){
+            text << "[Sequence] [HOLD] [K] \"" << triggers[i % 16] << "\" \"down shift, wait 0." << (i % 9 + 1)
+                 << ", click lmb, wait 0.3, click k, repeat 3, up shift, wait 1\"\n";
+        }
+        std::istringstream in(text.str());
+        Profile *p = new Profile();
+        ParseMacros(in, keys, *p);
+        engine.SetProfile(p);
+        source.Start(&engine);
+        for(const auto m : p->macros) source.Feed(static_cast<uint8_t>(MapConfigCodeToDetectVK((int)m->triggerCfg)), true);
+        sink.records.reserve(1 << 22);
+
+        auto t0 = std::chrono::steady_clock::now();
+        RunEngineUntil(engine, clock, kRunNs);
+        auto t1 = std::chrono::steady_clock::now();
+        size_t steps = 0;
+        for(const auto m : p->macros) steps += m->stats.clicks.load();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (steps ? steps : 1);
+        std::printf("%8d %12zu %14.2f %14llu\n", n, steps, ns, (unsigned long long)sink.sendCalls);
+        BenchRecord("engine", "sequences=" + std::to_string(n), "sequence", ns, "ns/press");
+    }
+}
+
+int BenchEngine(){
+    KeyMap keys;
+    BenchInputPath(keys);
+    BenchTimerPath(keys);
+    BenchSequencePath(keys);
+    return 0;
+}
@@ -0,0 +1,203 @@
+// evdev recordings through LinuxEvdevSource: a short recorded session replayed on the
+// virtual clock with its original spacing, checked click for click, then a large
+// recording read on the source's own thread into a live engine for throughput.
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <linux/input.h>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "LinuxBackend.h"
+#include "SimBackend.h"
+
+// Builds a recording the way the kernel reports a device: each transition preceded by
+// its MSC_SCAN and followed by a SYN_REPORT
+class Recording {
+public:
+    void Key(double atS, uint16_t code, int32_t value){
+        Add(atS, EV_MSC, MSC_SCAN, code);
+        Add(atS, EV_KEY, code, value);
+        Add(atS, EV_SYN, SYN_REPORT, 0);
+    }
+    void Add(double atS, uint16_t type, uint16_t code, int32_t value){
+        input_event ev = {};
+        // Recordings carry wall-clock stamps; only the spacing between them matters
+        uint64_t us = 1700000000000000ull + static_cast<uint64_t>(atS * 1e6 + 0.5);
+        ev.input_event_sec = static_cast<decltype(ev.input_event_sec)>(us / 1000000ull);
+        ev.input_event_usec = static_cast<decltype(ev.input_event_usec)>(us % 1000000ull);
+        ev.type = type;
+        ev.code = code;
+        ev.value = value;
+        events.push_back(ev);
+    }
+    // Written to a temp file, which is returned; empty on failure
+    std::string Write() const {
+        char path[] = "/tmp/unimacro_evdevXXXXXX";
+        int fd = mkstemp(path);
+        if(fd < 0) return "";
+        size_t bytes = events.size() * sizeof(input_event);
+        bool ok = write(fd, events.data(), bytes) == static_cast<ssize_t>(bytes);
+        close(fd);
+        if(!ok){ unlink(path); return ""; }
+        return path;
+    }
+
+    std::vector<input_event> events;
+};
+
+static Profile *MakeProfile(const KeyMap &keys, const char *text){
+    std::istringstream in(text);
+    Profile *p = new Profile();
+    ParseMacros(in, keys, *p);
+    return p;
+}
+
+static size_t CountOps(const SimInputSink &sink, uint16_t vk, uint32_t flags, uint8_t type){
+    size_t n = 0;
+    for(const auto &r : sink.records) if(r.op.type == type && r.op.vk == vk && r.op.flags == flags) ++n;
+    return n;
+}
+
+// mouse4 held for one second under a 10 ms autoclicker, then an "e" bind pressed with
+// two autorepeats. Mouse motion in between must be ignored.
+static int BenchPaced(const KeyMap &keys){
+    Recording rec;
+    rec.Add(0.0, EV_SYN, SYN_REPORT, 0);
+    rec.Key(1.0, BTN_SIDE, 1);
+    for(int i = 1; i < 20; ++i){
+        rec.Add(1.0 + i * 0.04, EV_REL, REL_X, i);
+        rec.Add(1.0 + i * 0.04, EV_SYN, SYN_REPORT, 0);
+    }
+    rec.Key(2.0, BTN_SIDE, 0);
+    rec.Key(2.5, KEY_E, 1);
+    rec.Key(2.75, KEY_E, 2);
+    rec.Key(2.78, KEY_E, 2);
+    rec.Key(2.8, KEY_E, 0);
+    std::string path = rec.Write();
+    if(path.empty()){
+        std::printf("cannot write a recording to /tmp\n");
+        return 1;
+    }
+
+    SimClock clock;
+    SimInputSink sink(clock);
+    Engine engine(sink, clock);
+    engine.SetProfile(MakeProfile(keys,
+        "[AutoClick] [HOLD] [K] \"mouse4\" \"lmb\" [10]\n"
+        "[Bind] [K] \"e\" \"f\"\n"));
+    LinuxEvdevSource source(clock);
+    source.paced = true;
+    bool opened = source.Open(path);
+    unlink(path.c_str());
+    if(!opened){
+        std::printf("cannot open %s\n", path.c_str());
+        return 1;
+    }
+    for(uint64_t due; (due = source.NextDueNs()) != IClock::kForever;){
+        RunEngineUntil(engine, clock, due);
+        source.Pump(&engine);
+    }
+    RunEngineUntil(engine, clock, clock.NowNs() + 1000000000ull);
+
+    size_t clicks = CountOps(sink, 0, kMouseLeftDown, InjectOp::MOUSE);
+    size_t fDowns = CountOps(sink, 'F', 0, InjectOp::KEY);
+    size_t fUps = CountOps(sink, 'F', kKeyEventUp, InjectOp::KEY);
+    uint64_t firstClick = 0, lastClick = 0;
+    for(const auto &r : sink.records){
+        if(r.op.type != InjectOp::MOUSE || r.op.flags != kMouseLeftDown) continue;
+        if(!firstClick) firstClick = r.timeNs;
+        lastClick = r.timeNs;
+    }
+    std::printf("-- paced replay (virtual clock) --\n%10s %10s %10s %12s %12s %8s %8s\n",
+                "records", "delivered", "clicks", "first ms", "last ms", "f down", "f up");
+    std::printf("%10llu %10llu %10zu %12.3f %12.3f %8zu %8zu\n", (unsigned long long)source.records,
+                (unsigned long long)source.delivered, clicks, firstClick / 1e6, lastClick / 1e6, fDowns, fUps);
+    BenchRecord("evdev", "paced", "clicks", double(clicks), "clicks");
+
+    // One click per 10 ms of the recorded second, the first one period after the recorded
+    // press; the e bind holds f from the press, repeats included, until the release
+    int failed = 0;
+    if(source.records != rec.events.size() || source.delivered != 6){
+        std::printf("FAIL: read %llu of %zu records, delivered %llu of 6 transitions\n", (unsigned long long)source.records,
+                    rec.events.size(), (unsigned long long)source.delivered);
+        ++failed;
+    }
+    if(clicks != 100 || firstClick != 1010000000ull || lastClick > 2000000000ull){
+        std::printf("FAIL: expected 100 clicks from 1010 ms to 2000 ms\n");
+        ++failed;
+    }
+    if(fDowns != 1 || fUps != 1){
+        std::printf("FAIL: expected f pressed and released once\n");
+        ++failed;
+    }
+    return failed;
+}
+
+// Random key traffic, read as fast as possible on the source's thread while the
+// engine's worker runs on the real clock
+static int BenchThroughput(const KeyMap &keys){
+    const int kTransitions = 1000000;
+    Recording rec;
+    rec.events.reserve(kTransitions * 3);
+    static const uint16_t codes[] = { KEY_W, KEY_A, KEY_S, KEY_D, KEY_SPACE, KEY_LEFTSHIFT, KEY_E, KEY_Q, BTN_LEFT, BTN_SIDE };
+    std::mt19937 rng(7);
+    for(int i = 0; i < kTransitions; i += 2){
+        uint16_t code = codes[rng() % 10];
+        rec.Key(i * 0.001, code, 1);
+        rec.Key(i * 0.001 + 0.0005, code, 0);
+    }
+    std::string path = rec.Write();
+    if(path.empty()){
+        std::printf("cannot write a recording to /tmp\n");
+        return 1;
+    }
+
+    LinuxClock clock;
+    SimInputSink sink(clock);
+    Engine engine(sink, clock);
+    engine.SetProfile(MakeProfile(keys,
+        "[AutoClick] [HOLD] [K] \"mouse4\" \"lmb\" [1]\n"
+        "[Bind] [K] \"e\" \"f\"\n"
+        "[Bind] \"q\" \"r\"\n"));
+    LinuxEvdevSource source(clock);
+    bool opened = source.Open(path);
+    unlink(path.c_str());
+    if(!opened) return 1;
+    engine.Start();
+    auto t0 = std::chrono::steady_clock::now();
+    source.Start(&engine);
+    while(!source.Finished()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto t1 = std::chrono::steady_clock::now();
+    source.Stop();
+    engine.Stop();
+
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(source.records);
+    const LatencyHistogram &h = engine.hookResidency;
+    std::printf("-- threaded read (real clock) --\n%10s %10s %12s %12s %12s %10s\n",
+                "records", "delivered", "ns/record", "handler p50", "handler p99", "overflows");
+    std::printf("%10llu %10llu %12.2f %12.2f %12.2f %10llu\n", (unsigned long long)source.records,
+                (unsigned long long)source.delivered, ns, h.Percentile(0.50) / 1000.0, h.Percentile(0.99) / 1000.0,
+                (unsigned long long)engine.ringOverflows.load());
+    BenchRecord("evdev", "threaded", "read", ns, "ns/record");
+    BenchRecord("evdev", "threaded", "handler_p99", h.Percentile(0.99) / 1000.0, "us");
+    if(source.delivered != static_cast<uint64_t>(kTransitions)){
+        std::printf("FAIL: delivered %llu of %d transitions\n", (unsigned long long)source.delivered, kTransitions);
+        return 1;
+    }
+    return 0;
+}
+
+int BenchEvdev(){
+    KeyMap keys;
+    int failed = BenchPaced(keys);
+    failed += BenchThroughput(keys);
+    return failed;
+}
@@ -0,0 +1,82 @@
+// Hook residency with the worker thread live: how long OnInput holds the input
+// thread for unbound keys, bound keys and bound keys whose worker is busy injecting.
+// Timestamps come from the real clock, as they do inside the Win32 hooks.
+#include <cstdio>
+#include <random>
+#include <sstream>
+
+#include "Bench.h"
+#include "BenchPlatform.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+
+class CountingSink : public IInputSink {
+public:
+    void Send(const InjectOp *, size_t count) override { sent += count; }
+    uint64_t sent = 0;
+};
+
+static void Report(const char *name, Engine &engine){
+    const LatencyHistogram &h = engine.hookResidency;
+    std::printf("%-22s %10llu %10.2f %10.2f %10.2f %10llu\n", name, (unsigned long long)h.Count(),
+                h.Percentile(0.50) / 1000.0, h.Percentile(0.99) / 1000.0, h.Max() / 1000.0,
+                (unsigned long long)engine.ringOverflows.load());
+    BenchRecord("hook", name, "residency_p50", h.Percentile(0.50) / 1000.0, "us");
+    BenchRecord("hook", name, "residency_p99", h.Percentile(0.99) / 1000.0, "us");
+    BenchRecord("hook", name, "overflows", double(engine.ringOverflows.load()), "events");
+}
+
+int BenchHook(){
+    KeyMap keys;
+    BenchClock clock;
+    CountingSink sink;
+    SimInputSource source(clock);
+    Engine engine(sink, clock);
+
+    std::istringstream in(
+        "[AutoClick] [HOLD] [K] \"mouse4\" \"lmb\" [1]\n"
+        "[AutoClick] [TOGGLE] \"f6\" \"f5\" [0.5]\n"
+        "[Bind] \"x\" \"enter\"\n"
+        "[Bind] [K] \"e\" \"f\"\n");
+    Profile *p = new Profile();
+    ParseMacros(in, keys, *p);
+    engine.SetProfile(p);
+    source.Start(&engine);
+    engine.Start();
+
+    const int kEvents = 200000;
+    const uint8_t unbound[] = { 'A', 'S', 'D', 'W', 0x20, 0x10 };
+    const uint8_t bound[] = { 'X', 'E', kVkXButton1 };
+
+    std::printf("%-22s %10s %10s %10s %10s %10s\n", "events", "count", "p50 us", "p99 us", "max us", "overflows");
+    for(int i = 0; i < kEvents; ++i){
+        uint8_t vk = unbound[i % 6];
+        source.Feed(vk, true);
+        source.Feed(vk, false);
+    }
+    Report("unbound", engine);
+
+    engine.hookResidency.Reset();
+    for(int i = 0; i < kEvents; ++i){
+        uint8_t vk = bound[i % 3];
+        source.Feed(vk, true);
+        source.Feed(vk, false);
+        // Leave the worker time to drain, as real keystrokes are milliseconds apart
+        if((i & 63) == 0) clock.SleepNs(100000);
+    }
+    Report("bound", engine);
+
+    engine.hookResidency.Reset();
+    source.Feed(0x75, true);
+    for(int i = 0; i < kEvents; ++i){
+        uint8_t vk = bound[i % 3];
+        source.Feed(vk, true);
+        source.Feed(vk, false);
+        if((i & 63) == 0) clock.SleepNs(100000);
+    }
+    Report("bound + autoclicking", engine);
+
+    engine.Stop();
+    return 0;
+}
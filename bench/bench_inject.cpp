@@ -0,0 +1,70 @@
+// Click dispatch cost: rebuilding the ops through the old per-click if-chain versus
+// appending a macro's ops compiled at load time.
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "KeyCodes.h"
+#include "Profile.h"
+
+// The SendClickByConfigCode chain from before templates, writing into a buffer
+static size_t LegacyClickOps(int cfg, InjectOp *in){
+    if(cfg == 253){ in[0] = { InjectOp::MOUSE, 0, kMouseLeftDown, 0 }; in[1] = { InjectOp::MOUSE, 0, kMouseLeftUp, 0 }; return 2; }
+    if(cfg == 252){ in[0] = { InjectOp::MOUSE, 0, kMouseRightDown, 0 }; in[1] = { InjectOp::MOUSE, 0, kMouseRightUp, 0 }; return 2; }
+    if(cfg == 4){ in[0] = { InjectOp::MOUSE, 0, kMouseMiddleDown, 0 }; in[1] = { InjectOp::MOUSE, 0, kMouseMiddleUp, 0 }; return 2; }
+    if(cfg == 5 || cfg == 6){ int32_t which = (cfg==5)?kXButton1:kXButton2; in[0] = { InjectOp::MOUSE, 0, kMouseXDown, which }; in[1] = { InjectOp::MOUSE, 0, kMouseXUp, which }; return 2; }
+    if(cfg == 254){ in[0] = { InjectOp::MOUSE, 0, kMouseWheel, kWheelDelta }; return 1; }
+    if(cfg == 255){ in[0] = { InjectOp::MOUSE, 0, kMouseWheel, -kWheelDelta }; return 1; }
+    in[0] = { InjectOp::KEY, (uint16_t)cfg, 0, 0 }; in[1] = in[0]; in[1].flags = kKeyEventUp; return 2;
+}
+
+static volatile uint32_t sinkValue;
+
+int BenchInject(){
+    const int kClicks = 20000000;
+    const int targets[] = { 253, 252, 4, 5, 6, 254, 255, 'F', 0x20, 0x74 };
+    const int kTargets = sizeof(targets) / sizeof(targets[0]);
+
+    Profile profile;
+    for(int t : targets){
+        Macro *m = profile.NewMacro();
+        m->targetCfg = (uint32_t)t;
+        CompileInjection(*m);
+    }
+    const std::vector<Macro*> &macros = profile.macros;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(0, kTargets - 1);
+    std::vector<uint8_t> order(1 << 16);
+    for(auto &o : order) o = (uint8_t)pick(rng);
+
+    std::vector<InjectOp> batch;
+    batch.reserve(64);
+    uint32_t acc = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for(int i = 0; i < kClicks; ++i){
+        InjectOp ops[2];
+        size_t n = LegacyClickOps(targets[order[i & 0xFFFF]], ops);
+        batch.insert(batch.end(), ops, ops + n);
+        if(batch.size() >= 32){ acc += batch.back().flags; batch.clear(); }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for(int i = 0; i < kClicks; ++i){
+        const Macro *m = macros[order[i & 0xFFFF]];
+        batch.insert(batch.end(), m->ops, m->ops + m->downCount + m->upCount);
+        if(batch.size() >= 32){ acc += batch.back().flags; batch.clear(); }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    sinkValue = acc;
+
+    double legacyNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / kClicks;
+    double compiledNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / kClicks;
+    std::printf("%16s %12s\n", "path", "ns/click");
+    std::printf("%16s %12.2f\n", "if-chain", legacyNs);
+    std::printf("%16s %12.2f\n", "compiled ops", compiledNs);
+    BenchRecord("inject", "if-chain", "build", legacyNs, "ns/click");
+    BenchRecord("inject", "compiled", "build", compiledNs, "ns/click");
+    return 0;
+}
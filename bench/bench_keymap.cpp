@@ -0,0 +1,142 @@
+// Key name resolution: every name in KeyMapping.cfg and every trigger/target in the
+// sample profiles, resolved through the old path (lowercase copy, unordered_map, if-chain
+// of built-ins, std::stoi) and through KeyMap::Resolve. Both must agree on every name.
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <filesystem>
+
+#include "Bench.h"
+#include "KeyCodes.h"
+#include "KeyMap.h"
+#include "Profile.h"
+
+struct LegacyKeyMap {
+    std::unordered_map<std::string,int> names;
+
+    int Resolve(const std::string &name) const {
+        std::string n = toLowerStr(trim(name));
+        if(n.empty()) return -1;
+        auto it = names.find(n);
+        if(it != names.end()) return it->second;
+
+        if(n=="lmb" || n=="mouse1") return kCfgLmb;
+        if(n=="rmb" || n=="mouse2") return kCfgRmb;
+        if(n=="mmb" || n=="mouse3" || n=="mouse_middle") return kCfgMouseMiddle;
+        if(n=="mouse4") return kCfgMouseX1;
+        if(n=="mouse5") return kCfgMouseX2;
+        if(n=="mousewheel_up") return kCfgWheelUp;
+        if(n=="mousewheel_down") return kCfgWheelDown;
+
+        if(n=="space") return kVkSpace;
+        if(n=="shift") return kVkShift;
+        if(n=="ctrl")  return kVkControl;
+        if(n=="alt")   return kVkMenu;
+        if(n=="enter" || n=="return") return kVkReturn;
+        if(n=="esc" || n=="escape") return kVkEscape;
+        if(n=="tab") return kVkTab;
+        if(n=="backspace") return kVkBack;
+        if(n=="capslock") return kVkCapital;
+
+        if(n.size()>=2 && n[0]=='f'){
+            try{
+                int fn = std::stoi(n.substr(1));
+                if(fn >= 1 && fn <= 24) return kVkF1 + (fn-1);
+            }catch(...){}
+        }
+
+        if(n.size()==1){
+            char c = n[0];
+            if(c>='a' && c<='z') return (int)std::toupper(c);
+            if(c>='0' && c<='9') return (int)c;
+        }
+
+        try { return std::stoi(n,nullptr,0); } catch(...) {}
+        return -1;
+    }
+};
+
+static volatile int sink;
+
+int BenchKeyMap(){
+    const std::string cfg = UNIMACRO_CFG_DIR;
+    KeyMap keys;
+    keys.Load(cfg + "/KeyMapping.cfg");
+
+    // Same file through the old loader's map, so both sides map identical entries
+    LegacyKeyMap old;
+    std::vector<std::string> names;
+    {
+        std::ifstream in(cfg + "/KeyMapping.cfg");
+        std::string line;
+        while(std::getline(in, line)){
+            size_t pos = line.find_first_of("#;");
+            std::string s = trim(pos == std::string::npos ? line : line.substr(0, pos));
+            size_t eq = s.find('=');
+            if(eq != std::string::npos){
+                std::string rhs = trim(s.substr(eq + 1));
+                try { old.names[toLowerStr(trim(s.substr(0, eq)))] = std::stoi(rhs.substr(0, rhs.find_first_of(" \t")), nullptr, 0); } catch(...) {}
+            }
+            // Every "name=" on the line, including the ones the loader only reaches through built-ins
+            for(size_t i = 0; (i = s.find('=', i)) != std::string::npos; ++i){
+                size_t b = i;
+                while(b > 0 && !std::isspace((unsigned char)s[b-1])) --b;
+                if(b < i) names.push_back(s.substr(b, i - b));
+            }
+        }
+    }
+
+    std::vector<std::string> profiles;
+    for(const auto &e : std::filesystem::directory_iterator(cfg)){
+        if(e.path().extension() == ".ini") profiles.push_back(e.path().filename().string());
+    }
+    for(const auto &file : profiles){
+        std::ifstream in(cfg + "/" + file);
+        std::string line;
+        while(std::getline(in, line)){
+            size_t pos = line.find_first_of("#;");
+            std::string s = trim(pos == std::string::npos ? line : line.substr(0, pos));
+            MacroTokens t;
+            if(!ParseMacroLine(s, t)) continue;
+            names.push_back(std::string(t.trigger));
+            names.push_back(std::string(t.target));
+        }
+    }
+    // Spellings the resolver also has to handle: case, padding, F-keys and raw codes
+    for(const char *extra : { "LMB", " Space ", "Mouse4", "F13", "f24", "0x41", "65", "012", "unknown_key", "" }) names.push_back(extra);
+
+    size_t mismatches = 0;
+    for(const auto &n : names){
+        if(old.Resolve(n) != keys.Resolve(n)){
+            std::printf("mismatch: \"%s\" old %d new %d\n", n.c_str(), old.Resolve(n), keys.Resolve(n));
+            ++mismatches;
+        }
+    }
+
+    const int kRounds = 20000;
+    auto t0 = std::chrono::steady_clock::now();
+    int total = 0;
+    for(int r = 0; r < kRounds; ++r) for(const auto &n : names) total += old.Resolve(n);
+    auto t1 = std::chrono::steady_clock::now();
+    for(int r = 0; r < kRounds; ++r) for(const auto &n : names) total += keys.Resolve(n);
+    auto t2 = std::chrono::steady_clock::now();
+    sink = total;
+
+    double calls = double(kRounds) * names.size();
+    double oldNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / calls;
+    double newNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / calls;
+    std::printf("%zu names (%zu keymap entries, %zu profiles)\n", names.size(), keys.names.Size(), profiles.size());
+    std::printf("%-14s %10s\n", "resolver", "ns/name");
+    std::printf("%-14s %10.2f\n", "old", oldNs);
+    std::printf("%-14s %10.2f\n", "table", newNs);
+    std::printf("speedup %.1fx, %zu mismatches\n", oldNs / newNs, mismatches);
+    BenchRecord("keymap", "old", "resolve", oldNs, "ns/name");
+    BenchRecord("keymap", "table", "resolve", newNs, "ns/name");
+    BenchRecord("keymap", "table", "mismatches", double(mismatches), "names");
+    return mismatches ? 1 : 0;
+}
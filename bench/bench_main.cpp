@@ -0,0 +1,182 @@
+// unimacro_bench: runs the benchmark suites headless and optionally writes every
+// recorded number as JSON or CSV, so two builds can be compared line by line.
+//
+//   unimacro_bench [--list] [--json FILE] [--csv FILE] [--label NAME] [suite ...]
+//
+// With no suite names every suite runs. The human-readable tables always go to stdout.
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+
+#ifndef UNIMACRO_BUILD_TYPE
+#define UNIMACRO_BUILD_TYPE ""
+#endif
+
+struct BenchSuite {
+    const char *name;
+    const char *description;
+    int (*run)();
+};
+
+static const BenchSuite kSuites[] = {
+    { "dispatch",     "hook dispatch cost vs macro count, linear scan vs table",   BenchDispatch },
+    { "inject",       "click op building, if-chain vs compiled ops",               BenchInject },
+    { "parse",        "profile parse throughput and allocations per line",         BenchParse },
+    { "keymap",       "key name resolution, old resolver vs table",                BenchKeyMap },
+    { "profile_load", "profile load: parse vs compiled image vs cached file",      BenchProfileLoad },
+    { "engine",       "engine input and timer path on the simulated backend",      BenchEngine },
+    { "scheduler",    "scheduler jitter on the real clock, 0.1 ms to 100 ms",      BenchScheduler },
+    { "hook",         "hook residency with the worker thread live",                BenchHook },
+    { "reload",       "hot reload under load: lost events and unfreed profiles",   BenchReload },
+    { "contention",   "macro state under concurrent autoclickers, packed vs arena", BenchContention },
+    { "replay",       "input trace recording cost and replay timing error",        BenchReplay },
+    { "priority",     "timer jitter under CPU hogs, default vs realtime worker",   BenchPriority },
+    { "budget",       "injection budget: total rate, fair shares, bind latency",   BenchBudget },
+    { "wheel",        "wheel autoclick: one event per notch vs coalesced and smooth", BenchWheel },
+#if !defined(_WIN32)
+    { "evdev",        "evdev recordings: paced replay check and read throughput",  BenchEvdev },
+#endif
+};
+
+struct BenchResult {
+    std::string suite;
+    std::string variant;
+    std::string metric;
+    double value;
+    std::string unit;
+};
+
+static std::vector<BenchResult> results;
+
+void BenchRecord(const char *suite, const std::string &variant, const char *metric, double value, const char *unit){
+    results.push_back(BenchResult{ suite, variant, metric, value, unit });
+}
+
+// ---- Output ----
+static std::string CompilerName(){
+    char buf[64];
+#if defined(_MSC_VER)
+    std::snprintf(buf, sizeof(buf), "msvc %d", _MSC_FULL_VER);
+#elif defined(__clang__)
+    std::snprintf(buf, sizeof(buf), "clang %d.%d.%d", __clang_major__, __clang_minor__, __clang_patchlevel__);
+#elif defined(__GNUC__)
+    std::snprintf(buf, sizeof(buf), "gcc %d.%d.%d", __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__);
+#else
+    std::snprintf(buf, sizeof(buf), "unknown");
+#endif
+    return buf;
+}
+
+static std::string Timestamp(){
+    char buf[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buf;
+}
+
+static std::string JsonString(const std::string &s){
+    std::string out = "\"";
+    for(char c : s){
+        if(c == '"' || c == '\\'){ out += '\\'; out += c; }
+        else if(static_cast<unsigned char>(c) < 0x20){
+            char esc[8];
+            std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        }
+        else out += c;
+    }
+    return out + "\"";
+}
+
+static std::string CsvField(const std::string &s){
+    if(s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string out = "\"";
+    for(char c : s){
+        if(c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static void WriteJson(FILE *f, const std::string &label){
+    std::fprintf(f, "{\n  \"label\": %s,\n  \"compiler\": %s,\n  \"build_type\": %s,\n  \"time\": %s,\n  \"results\": [\n",
+                 JsonString(label).c_str(), JsonString(CompilerName()).c_str(),
+                 JsonString(UNIMACRO_BUILD_TYPE).c_str(), JsonString(Timestamp()).c_str());
+    for(size_t i = 0; i < results.size(); ++i){
+        const BenchResult &r = results[i];
+        std::fprintf(f, "    { \"suite\": %s, \"case\": %s, \"metric\": %s, \"value\": %.6g, \"unit\": %s }%s\n",
+                     JsonString(r.suite).c_str(), JsonString(r.variant).c_str(), JsonString(r.metric).c_str(),
+                     r.value, JsonString(r.unit).c_str(), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+}
+
+static void WriteCsv(FILE *f, const std::string &label){
+    std::fprintf(f, "label,suite,case,metric,value,unit\n");
+    for(const auto &r : results){
+        std::fprintf(f, "%s,%s,%s,%s,%.6g,%s\n", CsvField(label).c_str(), CsvField(r.suite).c_str(),
+                     CsvField(r.variant).c_str(), CsvField(r.metric).c_str(), r.value, CsvField(r.unit).c_str());
+    }
+}
+
+static bool WriteResults(const std::string &path, const std::string &label, void (*write)(FILE*, const std::string&)){
+    FILE *f = std::fopen(path.c_str(), "w");
+    if(!f){
+        std::fprintf(stderr, "unimacro_bench: cannot write %s\n", path.c_str());
+        return false;
+    }
+    write(f, label);
+    std::fclose(f);
+    return true;
+}
+
+static int Usage(){
+    std::fprintf(stderr, "usage: unimacro_bench [--list] [--json FILE] [--csv FILE] [--label NAME] [suite ...]\n");
+    return 2;
+}
+
+int main(int argc, char **argv){
+    std::string jsonPath, csvPath, label;
+    std::vector<const BenchSuite*> selected;
+    for(int i = 1; i < argc; ++i){
+        const char *arg = argv[i];
+        if(std::strcmp(arg, "--list") == 0){
+            for(const auto &s : kSuites) std::printf("%-14s %s\n", s.name, s.description);
+            return 0;
+        }
+        else if(std::strcmp(arg, "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+        else if(std::strcmp(arg, "--csv") == 0 && i + 1 < argc) csvPath = argv[++i];
+        else if(std::strcmp(arg, "--label") == 0 && i + 1 < argc) label = argv[++i];
+        else if(arg[0] == '-') return Usage();
+        else{
+            const BenchSuite *found = nullptr;
+            for(const auto &s : kSuites) if(std::strcmp(s.name, arg) == 0) found = &s;
+            if(!found){
+                std::fprintf(stderr, "unimacro_bench: unknown suite \"%s\" (see --list)\n", arg);
+                return 2;
+            }
+            selected.push_back(found);
+        }
+    }
+    if(selected.empty()) for(const auto &s : kSuites) selected.push_back(&s);
+
+    int failed = 0;
+    for(const BenchSuite *s : selected){
+        std::printf("==== %s: %s ====\n", s->name, s->description);
+        std::fflush(stdout);
+        if(s->run() != 0){
+            std::printf("==== %s FAILED ====\n", s->name);
+            ++failed;
+        }
+        std::printf("\n");
+    }
+
+    bool written = true;
+    if(!jsonPath.empty()) written &= WriteResults(jsonPath, label, WriteJson);
+    if(!csvPath.empty()) written &= WriteResults(csvPath, label, WriteCsv);
+    return failed || !written ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+// Profile parse throughput on large generated profiles, and heap allocations per line:
+// a file of only comments, blanks and rejected lines should parse without allocating,
+// and a valid line should cost only the macro it produces. Last, a profile past the
+// macro limit must keep the first kMaxMacros and reject each line after them.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+#include "Bench.h"
+#include "KeyMap.h"
+#include "Profile.h"
+
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(size_t size){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// Arena blocks come from the aligned overloads; count those too
+void *operator new(size_t size, std::align_val_t align){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t a = static_cast<size_t>(align);
+    size = size ? (size + a - 1) / a * a : a;
+#if defined(_MSC_VER)
+    if(void *p = _aligned_malloc(size, a)) return p;
+#else
+    if(void *p = std::aligned_alloc(a, size)) return p;
+#endif
+    throw std::bad_alloc();
+}
+#if defined(_MSC_VER)
+void operator delete(void *p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+static const char *kTriggers[] = { "mouse4", "mouse5", "q", "e", "r", "t", "y", "u", "i", "o", "p", "z", "x", "c", "v", "b" };
+static const char *kTargets[]  = { "lmb", "rmb", "f5", "space", "mousewheel_down", "k", "l", "j" };
+
+// Roughly what a hand-maintained profile looks like: comments, blank lines, macros
+static std::string MakeProfile(size_t lines, bool valid){
+    std::string out;
+    for(size_t i = 0; i < lines; ++i){
+        const char *trg = kTriggers[i % 16];
+        const char *tgt = kTargets[i % 8];
+        switch(i % 4){
+            case 0: out += "; ---- section " + std::to_string(i) + " ----\n"; break;
+            case 1: out += "\n"; break;
+            case 2:
+                if(valid) out += std::string("[AutoClick] [HOLD] [K] \"") + trg + "\" \"" + tgt + "\" [" + std::to_string(i % 30 + 1) + "]   # rapid\n";
+                else out += std::string("[AutoClick] [HOLD] [K] \"") + trg + "\" \"" + tgt + "\" [fast]\n";
+                break;
+            case 3:
+                if(valid) out += std::string("[Bind] [K] \"") + trg + "\" \"" + tgt + "\"\n";
+                else out += std::string("[Bind] [K] \"") + trg + "\" \"no_such_key\"\n";
+                break;
+        }
+    }
+    return out;
+}
+
+int BenchParse(){
+    KeyMap keys;
+    std::printf("%-8s %8s %10s %10s %12s %12s\n", "profile", "lines", "MB/s", "Mlines/s", "allocs/line", "allocs/macro");
+    for(bool valid : { true, false }){
+        for(size_t lines : { 10000, 100000 }){
+            std::string text = MakeProfile(lines, valid);
+            const int kRounds = lines > 10000 ? 5 : 50;
+            double best = 1e300;
+            uint64_t allocs = 0;
+            size_t macros = 0;
+            for(int r = 0; r < kRounds; ++r){
+                Profile *p = new Profile();
+                uint64_t before = allocations.load();
+                auto t0 = std::chrono::steady_clock::now();
+                ParseMacros(text, keys, *p);
+                auto t1 = std::chrono::steady_clock::now();
+                allocs = allocations.load() - before;
+                macros = p->macros.size();
+                delete p;
+                double s = std::chrono::duration<double>(t1 - t0).count();
+                if(s < best) best = s;
+            }
+            std::printf("%-8s %8zu %10.1f %10.2f %12.3f %12.2f\n", valid ? "valid" : "rejects", lines,
+                        text.size() / best / 1e6, lines / best / 1e6, double(allocs) / lines,
+                        macros ? double(allocs) / macros : 0.0);
+            std::string variant = std::string(valid ? "valid" : "rejects") + ",lines=" + std::to_string(lines);
+            BenchRecord("parse", variant, "throughput", text.size() / best / 1e6, "MB/s");
+            BenchRecord("parse", variant, "allocations", double(allocs) / lines, "allocs/line");
+        }
+    }
+
+    std::string many;
+    for(size_t i = 0; i < 70000; ++i) many += "[Bind] \"q\" \"e\"\n";
+    Profile p;
+    std::vector<ParseError> errors;
+    ParseMacros(many, keys, p, &errors);
+    bool limited = p.macros.size() == kMaxMacros && errors.size() == 70000 - kMaxMacros
+                && errors[0].line == kMaxMacros + 1 && errors[0].column == 1 && errors[0].message == "too many macros"
+                && p.dispatch.entries.size() == kMaxMacros;
+    std::printf("macro limit: %zu macros kept, %zu lines rejected%s\n", p.macros.size(), errors.size(), limited ? "" : "  FAIL");
+    return limited ? 0 : 1;
+}
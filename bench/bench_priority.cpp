@@ -0,0 +1,85 @@
+// Timer jitter against CPU load: a 1 ms autoclicker on the real clock while a spinning
+// thread runs on every core, first with the worker left at normal priority and then
+// with the profile raising it to realtime and pinning it to one core. Without the
+// privilege to raise threads the tuner is refused and both runs look alike.
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "BenchPlatform.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+
+class TallySink : public IInputSink {
+public:
+    void Send(const InjectOp *, size_t count) override { sent += count; }
+    uint64_t sent = 0;
+};
+
+static int RunPolicy(const KeyMap &keys, const char *variant, const std::string &settings, unsigned hogs){
+    BenchClock clock;
+    TallySink sink;
+    SimInputSource source(clock);
+    BenchThreadTuner tuner;
+    Engine engine(sink, clock);
+    engine.threadTuner = &tuner;
+    std::istringstream in(settings + "[AutoClick] [TOGGLE] \"f6\" \"f5\" [1]\n");
+    Profile *p = new Profile();
+    ParseMacros(in, keys, *p);
+    bool tuned = p->injectPolicy != ThreadPolicy();
+    engine.SetProfile(p);
+    source.Start(&engine);
+    engine.Start();
+
+    std::atomic_bool stop{false};
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < hogs; ++i){
+        threads.emplace_back([&]{
+            volatile uint64_t spin = 0;
+            while(!stop.load(std::memory_order_relaxed)) ++spin;
+        });
+    }
+    source.Feed(kVkF1 + 5, true);
+    source.Feed(kVkF1 + 5, false);
+    clock.SleepNs(1000000000ull);
+    source.Feed(kVkF1 + 5, true);
+    source.Feed(kVkF1 + 5, false);
+    stop.store(true);
+    for(auto &t : threads) t.join();
+    engine.Stop();
+
+    const MacroStats &st = p->macros[0]->stats;
+    double p50 = st.lateness.Percentile(0.50) / 1000.0, p99 = st.lateness.Percentile(0.99) / 1000.0;
+    double max = st.lateness.Max() / 1000.0;
+    bool refused = engine.workerPolicyFailures.load() != 0;
+    std::printf("%10s %8u %8llu %10.1f %10.1f %10.1f %10s\n", variant, hogs, (unsigned long long)st.clicks.load(),
+                p50, p99, max, tuned ? (refused ? "refused" : "applied") : "-");
+    BenchRecord("priority", variant, "late_p50", p50, "us");
+    BenchRecord("priority", variant, "late_p99", p99, "us");
+    BenchRecord("priority", variant, "late_max", max, "us");
+    if(tuned && p->injectPolicy.priority != ThreadPolicy::REALTIME){
+        std::printf("FAIL: %s settings were not parsed\n", variant);
+        return 1;
+    }
+    if(st.clicks.load() == 0){
+        std::printf("FAIL: %s autoclicker never fired\n", variant);
+        return 1;
+    }
+    return 0;
+}
+
+int BenchPriority(){
+    KeyMap keys;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::string pin = std::to_string(cores - 1);
+    std::printf("%10s %8s %8s %10s %10s %10s %10s\n", "worker", "hogs", "clicks", "p50 us", "p99 us", "max us", "policy");
+    int failed = RunPolicy(keys, "default", "", cores);
+    failed += RunPolicy(keys, "realtime", "[Priority] [Inject] \"realtime\"\n[Cores] [Inject] \"" + pin + "\"\n", cores);
+    return failed;
+}
@@ -0,0 +1,142 @@
+// Profile load cost for every sample .ini in CFG plus one large synthetic profile:
+// reading and parsing the text, rebuilding from a compiled image already in memory, and
+// the full cached path the app takes on start and tray switch (stamp the .ini, map the
+// .umc, rebuild). The last column is read + parse over the cached path, and a hit must
+// report the same rejected lines as a parse. Then the cost of a per-application switch
+// once every profile is resident: no file is touched.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "Bench.h"
+#include "BenchPlatform.h"
+#include "KeyMap.h"
+#include "ProfileCache.h"
+#include "ProfileRegistry.h"
+#include "SimBackend.h"
+
+static std::string ReadFile(const std::string &path){
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+template <typename F>
+static double NsPerCall(int iterations, F &&fn){
+    auto t0 = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i) fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+}
+
+int BenchProfileLoad(){
+    const std::string cfg = UNIMACRO_CFG_DIR;
+    KeyMap keys;
+    keys.Load(cfg + "/KeyMapping.cfg");
+
+    std::vector<std::string> files;
+    for(const auto &e : std::filesystem::directory_iterator(cfg)){
+        if(e.path().extension() == ".ini") files.push_back(e.path().filename().string());
+    }
+
+    // Plus one large synthetic profile, the size a heavy per-game setup reaches
+    std::ostringstream big;
+    static const char *triggers[] = { "mouse4", "mouse5", "q", "e", "r", "t", "y", "u", "i", "o", "p", "z", "x", "c", "v", "b" };
+    static const char *targets[]  = { "lmb", "rmb", "f5", "space", "mousewheel_down", "k", "l", "j" };
+    for(int i = 0; i < 512; ++i){
+        if(i % 2) big << "[Bind] [K] \"" << triggers[i % 16] << "\" \"" << targets[i % 8] << "\"\n";
+        else big << "; autoclicker " << i << "\n[AutoClick] [HOLD] [K] \"" << triggers[i % 16] << "\" \"" << targets[i % 8] << "\" [" << (i % 20 + 1) << "]\n";
+    }
+    big << "[AutoClick] [HOLD] \"mouse4\" \"lmb\" [0]\n";
+    std::vector<std::pair<std::string, std::string>> profiles;
+    for(const auto &file : files) profiles.push_back({ file, ReadFile(cfg + "/" + file) });
+    profiles.push_back({ "synthetic-512.ini", big.str() });
+
+    // Cached path runs on copies so the source tree never gets .umc files
+    std::error_code ec;
+    std::filesystem::path tmpDir = std::filesystem::temp_directory_path(ec) / "unimacro_bench_cache";
+    std::filesystem::create_directories(tmpDir, ec);
+    std::string tmp = tmpDir.string();
+
+    const int kIterations = 2000;
+    int failed = 0;
+    std::printf("%-22s %7s %12s %12s %12s %9s\n", "profile", "macros", "read+parse", "image us", "cached us", "speedup");
+    for(const auto &entry : profiles){
+        const std::string &file = entry.first;
+        const std::string &source = entry.second;
+        uint64_t hash = ProfileSourceHash(source, keys);
+        Profile parsed;
+        std::vector<ParseError> errors;
+        ParseMacros(source, keys, parsed, &errors);
+        std::vector<uint8_t> image = CompileProfile(parsed, hash, 0, &errors);
+
+        // Written an hour back, as a profile is by the time it is loaded again
+        std::string copy = tmp + "/" + file;
+        std::ofstream(copy, std::ios::binary) << source;
+        std::filesystem::last_write_time(copy, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1), ec);
+
+        double parseNs = NsPerCall(kIterations, [&]{
+            BenchMappedFile ini;
+            ini.Open(copy);
+            Profile p;
+            ParseMacros(std::string_view(reinterpret_cast<const char*>(ini.Data()), ini.Size()), keys, p);
+        });
+        double imageNs = NsPerCall(kIterations, [&]{
+            Profile p;
+            LoadCompiledProfile(image.data(), image.size(), hash, p);
+        });
+
+        Profile warm;
+        LoadProfileCached<BenchMappedFile>(copy, keys, warm);
+        bool hit = true;
+        double cachedNs = NsPerCall(kIterations, [&]{
+            Profile p;
+            hit &= LoadProfileCached<BenchMappedFile>(copy, keys, p) == CacheResult::HIT;
+        });
+        Profile reported;
+        std::vector<ParseError> hitErrors;
+        LoadProfileCached<BenchMappedFile>(copy, keys, reported, &hitErrors);
+        std::remove(CompiledProfilePath(copy).c_str());
+        std::remove(copy.c_str());
+
+        std::printf("%-22s %7zu %12.2f %12.2f %12.2f %8.1fx%s\n", file.c_str(), parsed.macros.size(),
+                    parseNs / 1000.0, imageNs / 1000.0, cachedNs / 1000.0, parseNs / cachedNs, hit ? "" : " (miss)");
+        if(!hit || hitErrors.size() != errors.size()){
+            std::printf("FAIL: %s %s, %zu rejected lines reported against %zu parsed\n", file.c_str(),
+                        hit ? "hit" : "missed", hitErrors.size(), errors.size());
+            ++failed;
+        }
+        BenchRecord("profile_load", file, "parse", parseNs / 1000.0, "us");
+        BenchRecord("profile_load", file, "image", imageNs / 1000.0, "us");
+        BenchRecord("profile_load", file, "cached", cachedNs / 1000.0, "us");
+    }
+    std::filesystem::remove(tmpDir, ec);
+
+    // Round-robin over every profile, each switch adopted by the worker as on a focus change
+    SimClock clock;
+    SimInputSink sink(clock);
+    Engine engine(sink, clock);
+    {
+        ProfileRegistry registry(engine);
+        for(const auto &entry : profiles){
+            Profile *p = new Profile();
+            ParseMacros(entry.second, keys, *p);
+            registry.Put(entry.first, entry.first, p);
+        }
+        size_t n = registry.Entries().size();
+        size_t next = 0;
+        double switchNs = NsPerCall(kIterations * 10, [&]{
+            registry.Activate(next++ % n);
+            engine.RunDue(clock.NowNs());
+        });
+        std::printf("resident switch over %zu profiles: %.2f us\n", n, switchNs / 1000.0);
+        BenchRecord("profile_load", "resident", "switch", switchNs / 1000.0, "us");
+    }
+    return failed;
+}
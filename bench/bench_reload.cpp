@@ -0,0 +1,109 @@
+// Hot reload under load: an input thread feeds bound and unbound keys while the
+// control thread swaps freshly parsed profiles in a loop and the worker keeps
+// autoclicking. Checks that no event is lost or dropped across swaps, that the worker
+// frees every retired profile by itself, released resident ones included, and reports
+// hook residency during reloads.
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+#include "Bench.h"
+#include "BenchPlatform.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+
+class SharedCountingSink : public IInputSink {
+public:
+    void Send(const InjectOp *, size_t count) override { sent.fetch_add(count); }
+    std::atomic<uint64_t> sent{0};
+};
+
+static Profile *BuildProfile(const KeyMap &keys, int variant){
+    // Alternate between two layouts so every swap changes the dispatch and suppress tables
+    std::ostringstream text;
+    text << "[AutoClick] [TOGGLE] \"f6\" \"lmb\" [" << (variant & 1 ? 2 : 1) << "]\n";
+    text << "[Bind] \"x\" \"enter\"\n";
+    if(variant & 1) text << "[Bind] [K] \"e\" \"f\"\n";
+    else text << "[Bind] \"q\" \"r\"\n";
+    std::istringstream in(text.str());
+    Profile *p = new Profile();
+    ParseMacros(in, keys, *p);
+    return p;
+}
+
+int BenchReload(){
+    KeyMap keys;
+    BenchClock clock;
+    SharedCountingSink sink;
+    SimInputSource source(clock);
+    Engine engine(sink, clock);
+
+    engine.SetProfile(BuildProfile(keys, 0));
+    source.Start(&engine);
+    engine.Start();
+
+    // X is bound in every variant, so every X event must reach the worker
+    const int kEvents = 400000;
+    std::atomic_bool feeding{true};
+    std::thread input([&]{
+        source.Feed(0x75, true);
+        source.Feed(0x75, false);
+        for(int i = 0; i < kEvents; ++i){
+            source.Feed('X', true);
+            source.Feed('X', false);
+            source.Feed('A', true);
+            source.Feed('A', false);
+            if((i & 63) == 0) clock.SleepNs(50000);
+        }
+        feeding.store(false);
+    });
+
+    int reloads = 0;
+    uint64_t t0 = clock.NowNs();
+    while(feeding.load()){
+        engine.SetProfile(BuildProfile(keys, ++reloads));
+        clock.SleepNs(200000);
+    }
+    uint64_t t1 = clock.NowNs();
+    input.join();
+
+    // A resident profile swapped out and handed back, as the registry does on a reload
+    Profile *resident = BuildProfile(keys, 0);
+    engine.UseProfile(resident);
+    clock.SleepNs(1000000);
+    engine.SetProfile(BuildProfile(keys, ++reloads));
+    engine.ReleaseProfile(resident);
+
+    // Let the worker drain and adopt the final profile; it frees the rest without Reclaim
+    uint64_t expected = 2 + 2ull * kEvents - engine.ringOverflows.load();
+    for(int i = 0; i < 1000 && engine.processedEvents.load() < expected; ++i) clock.SleepNs(1000000);
+    // Long enough for the worker to have taken the release, so the count below is not read early
+    clock.SleepNs(20000000);
+    size_t retired = engine.RetiredProfiles();
+    for(int i = 0; i < 1000 && retired > 0; ++i){
+        clock.SleepNs(1000000);
+        retired = engine.RetiredProfiles();
+    }
+
+    const LatencyHistogram &h = engine.hookResidency;
+    std::printf("reloads            %10d (%.1f/s)\n", reloads, reloads / ((t1 - t0) / 1e9));
+    std::printf("bound events       %10llu\n", (unsigned long long)(2 + 2ull * kEvents));
+    std::printf("processed          %10llu\n", (unsigned long long)engine.processedEvents.load());
+    std::printf("ring overflows     %10llu\n", (unsigned long long)engine.ringOverflows.load());
+    std::printf("injected           %10llu\n", (unsigned long long)sink.sent.load());
+    std::printf("hook p50/p99/max   %10.2f %.2f %.2f us\n",
+                h.Percentile(0.50) / 1000.0, h.Percentile(0.99) / 1000.0, h.Max() / 1000.0);
+
+    std::printf("retired, not freed %10zu\n", retired);
+    engine.Stop();
+
+    bool ok = engine.processedEvents.load() == expected && retired == 0;
+    BenchRecord("reload", "", "reloads", reloads / ((t1 - t0) / 1e9), "reloads/s");
+    BenchRecord("reload", "", "lost_events", double(expected - engine.processedEvents.load()), "events");
+    BenchRecord("reload", "", "unfreed_profiles", double(retired), "profiles");
+    BenchRecord("reload", "", "hook_p99", h.Percentile(0.99) / 1000.0, "us");
+    std::printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
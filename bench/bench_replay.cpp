@@ -0,0 +1,209 @@
+// Input traces end to end: the recorder's cost on the input thread and whether its
+// writer keeps up, then a [Replay] of a trace, checked event for event on the virtual
+// clock and timed on the real one, where each event's lateness is the replay error.
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "BenchPlatform.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+#include "TraceRecorder.h"
+
+class NullHandler : public IInputHandler {
+public:
+    bool OnInput(const InputEvent &) override { return false; }
+};
+
+static std::string TempTracePath(const char *name){
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static bool WriteTrace(const std::string &path, const std::vector<TraceRecord> &records){
+    FILE *f = std::fopen(path.c_str(), "wb");
+    if(!f) return false;
+    TraceHeader header = MakeTraceHeader(0);
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1
+           && std::fwrite(records.data(), sizeof(TraceRecord), records.size(), f) == records.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+// A session of key taps, a held button and wheel notches, one event every stepNs
+static std::vector<TraceRecord> MakeSession(size_t events, uint64_t stepNs){
+    static const uint8_t keys[] = { 'W', 'A', 'S', 'D', 0x20, kVkLShift };
+    std::vector<TraceRecord> out;
+    for(size_t i = 0; out.size() < events; ++i){
+        TraceRecord r = {};
+        r.timeNs = out.size() * stepNs;
+        switch(i % 4){
+            case 0: r.kind = TraceRecord::KEY; r.vk = keys[(i / 4) % 6]; r.down = 1; break;
+            case 1: r.kind = TraceRecord::KEY; r.vk = keys[(i / 4) % 6]; r.down = 0; break;
+            case 2: r.kind = TraceRecord::BUTTON; r.vk = (i / 4) % 2 ? kVkLButton : kVkXButton1; r.down = (i / 8) % 2 == 0; break;
+            case 3: r.kind = TraceRecord::WHEEL; r.wheel = (i / 4) % 3 == 0 ? -kWheelDelta : kWheelDelta; break;
+        }
+        out.push_back(r);
+    }
+    return out;
+}
+
+// ---- Recording ----
+// Events fed from this thread as the hook would, either paced at a high but human
+// rate or flooded as fast as possible, where the ring fills and drops instead of waiting
+static int BenchRecording(){
+    std::printf("-- recording --\n%8s %10s %12s %10s %10s %10s\n", "feed", "events", "hook ns/ev", "recorded", "dropped", "in file");
+    int failed = 0;
+    for(bool flood : { false, true }){
+        BenchClock clock;
+        NullHandler next;
+        TraceRecorder recorder(next);
+        std::string path = TempTracePath("unimacro_bench_record.umt");
+        if(!recorder.Start(path, clock.NowNs())){
+            std::printf("cannot write %s\n", path.c_str());
+            return 1;
+        }
+        const int kEvents = 200000;
+        const int kBurst = 500;
+        double hookNs = 0;
+        for(int done = 0; done < kEvents; done += kBurst){
+            auto t0 = std::chrono::steady_clock::now();
+            for(int i = 0; i < kBurst; ++i){
+                InputEvent ev;
+                ev.timeNs = clock.NowNs();
+                ev.vk = static_cast<uint8_t>('A' + (done + i) / 2 % 26);
+                ev.down = (i % 2) == 0;
+                recorder.OnInput(ev);
+            }
+            hookNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+            // 500 events per millisecond is still far beyond any physical input
+            if(!flood) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        recorder.Stop();
+
+        BenchMappedFile file;
+        const TraceRecord *records = nullptr;
+        size_t count = 0;
+        bool valid = file.Open(path) && ViewTrace(file.Data(), file.Size(), records, count);
+        bool ordered = valid;
+        for(size_t i = 1; ordered && i < count; ++i) ordered = records[i].timeNs >= records[i - 1].timeNs;
+        file.Close();
+        std::filesystem::remove(path);
+
+        const char *feed = flood ? "flood" : "paced";
+        std::printf("%8s %10d %12.2f %10llu %10llu %10zu\n", feed, kEvents, hookNs / kEvents,
+                    (unsigned long long)recorder.recorded.load(), (unsigned long long)recorder.dropped.load(), count);
+        BenchRecord("replay", std::string("record,") + feed, "hook", hookNs / kEvents, "ns/event");
+        BenchRecord("replay", std::string("record,") + feed, "dropped", double(recorder.dropped.load()), "events");
+        if(!valid || !ordered || count != recorder.recorded.load() || recorder.WriteFailed()
+           || (!flood && recorder.dropped.load() != 0)){
+            std::printf("FAIL: %s trace does not hold every recorded event in order\n", feed);
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+// ---- Replay ----
+static Profile *ReplayProfile(const KeyMap &keys, const std::string &tracePath, const char *mode){
+    std::istringstream in(std::string("[Replay] ") + mode + " \"f9\" \"" + tracePath + "\"\n");
+    Profile *p = new Profile();
+    ParseMacros(in, keys, *p);
+    AttachTraces<BenchMappedFile>(*p, "");
+    return p;
+}
+
+// On the virtual clock every event must go out exactly on its slot: origin + recorded time
+static int BenchReplayVirtual(const KeyMap &keys, const std::string &path, const std::vector<TraceRecord> &session){
+    SimClock clock;
+    SimInputSink sink(clock);
+    SimInputSource source(clock);
+    Engine engine(sink, clock);
+    Profile *p = ReplayProfile(keys, path, "[ONCE]");
+    engine.SetProfile(p);
+    source.Start(&engine);
+    clock.AdvanceTo(1000000000ull);
+    uint64_t origin = clock.NowNs();
+    source.Feed(kVkF1 + 8, true);
+    source.Feed(kVkF1 + 8, false);
+    RunEngineUntil(engine, clock, origin + session.back().timeNs + 1000000000ull);
+
+    // Releases of buttons pressed before the trace began are not sent
+    size_t expected = 0, exact = 0;
+    KeySet held;
+    for(const auto &r : session){
+        int key = r.kind == TraceRecord::WHEEL ? -1 : r.vk;
+        if(key >= 0 && !r.down && !held.Test(key)) continue;
+        if(key >= 0){
+            if(r.down) held.Set(key);
+            else held.Reset(key);
+        }
+        if(expected < sink.records.size() && sink.records[expected].timeNs == origin + r.timeNs) ++exact;
+        ++expected;
+    }
+    const Macro *m = p->macros.empty() ? nullptr : p->macros[0];
+    bool loaded = m && m->trace && m->trace->count == session.size();
+    std::printf("-- replay (virtual clock) --\n%10s %10s %10s %10s\n", "events", "sent", "on time", "active");
+    std::printf("%10zu %10zu %10zu %10s\n", session.size(), sink.records.size(), exact, m && m->active.load() ? "yes" : "no");
+    if(!loaded || sink.records.size() != expected || exact != expected || m->active.load()){
+        std::printf("FAIL: expected %zu events sent on their recorded times and the run ended\n", expected);
+        return 1;
+    }
+    return 0;
+}
+
+// On the real clock the lateness histogram of the replay is its error against the timeline
+static int BenchReplayReal(const KeyMap &keys, const std::string &path, const std::vector<TraceRecord> &session){
+    BenchClock clock;
+    SimInputSink sink(clock);
+    SimInputSource source(clock);
+    Engine engine(sink, clock);
+    Profile *p = ReplayProfile(keys, path, "[ONCE]");
+    engine.SetProfile(p);
+    source.Start(&engine);
+    sink.records.reserve(session.size());
+    engine.Start();
+    source.Feed(kVkF1 + 8, true);
+    source.Feed(kVkF1 + 8, false);
+    // Catching up after a late wakeup shifts the rest of the run, so wait for it to end
+    clock.SleepNs(session.back().timeNs);
+    for(int i = 0; i < 500 && p->macros[0]->active.load(); ++i) clock.SleepNs(10000000ull);
+    engine.Stop();
+
+    const MacroStats &st = p->macros[0]->stats;
+    double p50 = st.lateness.Percentile(0.50) / 1000.0, p99 = st.lateness.Percentile(0.99) / 1000.0;
+    double max = st.lateness.Max() / 1000.0;
+    std::printf("-- replay (real clock, %.1f s) --\n%10s %10s %10s %12s %12s %12s\n", session.back().timeNs / 1e9,
+                "events", "sent", "missed", "p50 err us", "p99 err us", "max err us");
+    std::printf("%10zu %10llu %10llu %12.1f %12.1f %12.1f\n", session.size(),
+                (unsigned long long)st.fires.load(), (unsigned long long)st.missed.load(), p50, p99, max);
+    BenchRecord("replay", "real", "error_p50", p50, "us");
+    BenchRecord("replay", "real", "error_p99", p99, "us");
+    BenchRecord("replay", "real", "error_max", max, "us");
+    if(st.fires.load() != session.size()){
+        std::printf("FAIL: %llu of %zu events replayed\n", (unsigned long long)st.fires.load(), session.size());
+        return 1;
+    }
+    return 0;
+}
+
+int BenchReplay(){
+    KeyMap keys;
+    int failed = BenchRecording();
+
+    // 2 s of events, one every 0.5 ms
+    std::vector<TraceRecord> session = MakeSession(4000, 500000);
+    std::string path = TempTracePath("unimacro_bench_replay.umt");
+    if(!WriteTrace(path, session)){
+        std::printf("cannot write %s\n", path.c_str());
+        return failed + 1;
+    }
+    failed += BenchReplayVirtual(keys, path, session);
+    failed += BenchReplayReal(keys, path, session);
+    std::filesystem::remove(path);
+    return failed;
+}
@@ -0,0 +1,109 @@
+// Scheduler jitter on real time: runs the engine's scheduler thread on the host clock
+// with several active autoclickers and measures how far each click lands from its
+// slot on the ideal absolute timeline.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "Bench.h"
+#include "BenchPlatform.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+
+// Mouse targets whose button-down flags tell the macros' clicks apart
+static const char *kTargets[] = { "lmb", "rmb", "mouse_middle", "mouse4" };
+static const uint32_t kDownFlags[] = { kMouseLeftDown, kMouseRightDown, kMouseMiddleDown, kMouseXDown };
+
+// Records the wall time of every button-down that is sent
+class TimestampSink : public IInputSink {
+public:
+    explicit TimestampSink(IClock &clock) : clock(clock) {}
+    void Send(const InjectOp *ops, size_t count) override {
+        uint64_t t = clock.NowNs();
+        std::lock_guard<std::mutex> lock(mutex);
+        for(size_t i = 0; i < count; ++i){
+            if(ops[i].type == InjectOp::MOUSE) hits.push_back(Hit{ t, ops[i].flags });
+        }
+    }
+    struct Hit { uint64_t t; uint32_t flags; };
+    std::vector<Hit> hits;
+    std::mutex mutex;
+private:
+    IClock &clock;
+};
+
+static double Percentile(std::vector<double> &v, double p){
+    if(v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t i = static_cast<size_t>(p * (v.size() - 1));
+    return v[i];
+}
+
+int BenchScheduler(){
+    KeyMap keys;
+    const float intervals[] = { 0.1f, 0.5f, 1.0f, 2.5f, 10.0f, 100.0f };
+    const int kMacros = 4;
+    const uint64_t kRunNs = 2ull * 1000000000ull;
+    std::printf("%10s %8s %10s %8s %12s %12s %12s\n", "interval", "clicks", "expected", "missed", "p50 err us", "p99 err us", "max err us");
+    for(float interval : intervals){
+        BenchClock clock;
+        TimestampSink sink(clock);
+        SimInputSource source(clock);
+        Engine engine(sink, clock);
+        std::ostringstream text;
+        for(int i = 0; i < kMacros; ++i){
+            text << "[AutoClick] [TOGGLE] \"f" << (i + 1) << "\" \"" << kTargets[i] << "\" [" << interval << "]\n";
+        }
+        std::istringstream in(text.str());
+        Profile *p = new Profile();
+        ParseMacros(in, keys, *p);
+        engine.SetProfile(p);
+        source.Start(&engine);
+        engine.Start();
+
+        uint64_t start = clock.NowNs();
+        for(const auto m : p->macros) source.Feed(static_cast<uint8_t>(m->triggerCfg), true);
+        clock.SleepNs(kRunNs);
+        engine.Stop();
+
+        // Each click is assigned to its nearest slot counted from the macro's first click;
+        // the median offset from those slots fixes the macro's phase and the error is the
+        // distance from it. Skipped deadlines show up under "missed" only.
+        std::vector<double> err;
+        size_t clicks = 0;
+        for(size_t i = 0; i < p->macros.size(); ++i){
+            double period = (double)p->macros[i]->periodNs;
+            std::vector<double> offsets;
+            uint64_t first = 0;
+            for(const auto &h : sink.hits){
+                if(h.flags != kDownFlags[i]) continue;
+                ++clicks;
+                if(offsets.empty() && first == 0) first = h.t;
+                double d = (double)(h.t - first);
+                offsets.push_back(d - std::floor(d / period + 0.5) * period);
+            }
+            if(offsets.empty()) continue;
+            std::vector<double> sorted = offsets;
+            double phase = Percentile(sorted, 0.5);
+            for(double o : offsets) err.push_back(std::fabs(o - phase) / 1000.0);
+        }
+        double expected = kMacros * (double)(clock.NowNs() - start) / (double)p->macros[0]->periodNs;
+        double p50 = Percentile(err, 0.50), p99 = Percentile(err, 0.99);
+        double mx = err.empty() ? 0.0 : err.back();
+        std::printf("%10.2f %8zu %10.0f %8llu %12.1f %12.1f %12.1f\n", interval, clicks, expected,
+                    (unsigned long long)engine.missedTicks.load(), p50, p99, mx);
+        char variant[32];
+        std::snprintf(variant, sizeof(variant), "interval=%g", interval);
+        BenchRecord("scheduler", variant, "clicks", double(clicks), "clicks");
+        BenchRecord("scheduler", variant, "expected", expected, "clicks");
+        BenchRecord("scheduler", variant, "missed", double(engine.missedTicks.load()), "ticks");
+        BenchRecord("scheduler", variant, "error_p50", p50, "us");
+        BenchRecord("scheduler", variant, "error_p99", p99, "us");
+        BenchRecord("scheduler", variant, "error_max", mx, "us");
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Wheel autoclickers on the virtual clock, one notch per event against [Coalesce] and
+// [Smooth]: how many sink calls and events a second of scrolling takes, and whether the
+// distance scrolled is exactly what the interval asks for. The last rows run two
+// coalescing wheels at once, whose notches due together must share one event.
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+
+struct WheelCase {
+    const char *name;
+    const char *macros;
+    // Expected distance in 1/kWheelDelta notches after one second
+    int64_t expected;
+};
+
+static int RunWheel(const KeyMap &keys, const WheelCase &c){
+    SimClock clock;
+    SimInputSink sink(clock);
+    SimInputSource source(clock);
+    Engine engine(sink, clock);
+    std::istringstream in(c.macros);
+    Profile *p = new Profile();
+    ParseMacros(in, keys, *p);
+    engine.SetProfile(p);
+    source.Start(&engine);
+
+    clock.AdvanceTo(1000000000ull);
+    uint64_t start = clock.NowNs();
+    source.Feed(kVkF1 + 5, true);
+    RunEngineUntil(engine, clock, start + 1000000000ull);
+    engine.RunDue(clock.NowNs());
+
+    int64_t distance = 0;
+    for(const auto &r : sink.records){
+        if(r.op.type == InjectOp::MOUSE && r.op.flags == kMouseWheel) distance -= r.op.mouseData;
+    }
+    uint64_t notches = 0;
+    for(const Macro *m : p->macros) notches += m->stats.clicks.load();
+    std::printf("%-22s %10llu %10zu %12.2f %12.2f %10llu\n", c.name, (unsigned long long)sink.sendCalls, sink.records.size(),
+                double(distance) / kWheelDelta, double(c.expected) / kWheelDelta, (unsigned long long)notches);
+    BenchRecord("wheel", c.name, "sends", double(sink.sendCalls), "calls");
+    BenchRecord("wheel", c.name, "events", double(sink.records.size()), "events");
+    if(distance != c.expected || notches != static_cast<uint64_t>(c.expected / kWheelDelta)){
+        std::printf("FAIL: %s scrolled %lld units and counted %llu notches, expected %lld\n", c.name,
+                    (long long)distance, (unsigned long long)notches, (long long)c.expected);
+        return 1;
+    }
+    return 0;
+}
+
+int BenchWheel(){
+    KeyMap keys;
+    static const WheelCase cases[] = {
+        { "each,0.1ms",        "[AutoClick] [HOLD] \"f6\" \"mousewheel_down\" [0.1]\n",              10000 * kWheelDelta },
+        { "coalesce,0.1ms",    "[AutoClick] [HOLD] [Coalesce] \"f6\" \"mousewheel_down\" [0.1]\n",   10000 * kWheelDelta },
+        { "smooth,0.1ms",      "[AutoClick] [HOLD] [Smooth] \"f6\" \"mousewheel_down\" [0.1]\n",     10000 * kWheelDelta },
+        { "each,0.03ms",       "[AutoClick] [HOLD] \"f6\" \"mousewheel_down\" [0.03]\n",             33333 * kWheelDelta },
+        // Fires every 33 notches, 0.99 ms: the last 3 notches of the second wait for the next
+        { "coalesce,0.03ms",   "[AutoClick] [HOLD] [Coalesce] \"f6\" \"mousewheel_down\" [0.03]\n",  33330 * kWheelDelta },
+        { "each,3ms",          "[AutoClick] [HOLD] [D] \"f6\" \"mousewheel_down\" [3]\n",            333 * kWheelDelta },
+        { "coalesce,3ms",      "[AutoClick] [HOLD] [D] [Coalesce] \"f6\" \"mousewheel_down\" [3]\n", 333 * kWheelDelta },
+        { "smooth,3ms",        "[AutoClick] [HOLD] [D] [Smooth] \"f6\" \"mousewheel_down\" [3]\n",   40000 },
+        { "each,2x",           "[AutoClick] [HOLD] \"f6\" \"mousewheel_down\" [0.1]\n"
+                               "[AutoClick] [HOLD] \"f6\" \"mousewheel_down\" [0.25]\n",             14000 * kWheelDelta },
+        { "coalesce,2x",       "[AutoClick] [HOLD] [Coalesce] \"f6\" \"mousewheel_down\" [0.1]\n"
+                               "[AutoClick] [HOLD] [Coalesce] \"f6\" \"mousewheel_down\" [0.25]\n",  14000 * kWheelDelta },
+    };
+    std::printf("%-22s %10s %10s %12s %12s %10s\n", "variant", "sends", "events", "notches", "expected", "counted");
+    int failed = 0;
+    for(const auto &c : cases) failed += RunWheel(keys, c);
+
+    // Flags combine, only a wheel target takes the wheel ones and a misspelt flag is skipped
+    // with a warning, the macro kept
+    std::istringstream in("[AutoClick] [HOLD] [D] [Coalesce] \"f6\" \"mousewheel_down\" [3]\n"
+                          "[AutoClick] [HOLD] [Smooth] \"f7\" \"lmb\" [1]\n"
+                          "[AutoClick] [HOLD] [Coalese] \"f8\" \"mousewheel_down\" [1]\n");
+    Profile p;
+    std::vector<ParseError> errors;
+    ParseMacros(in, keys, p, &errors);
+    if(p.macros.size() != 2 || !p.macros[0]->dropOriginal || p.macros[0]->wheelMode != Macro::WHEEL_COALESCE
+       || p.macros[1]->wheelMode != Macro::WHEEL_EACH || errors.size() != 2 || errors[0].warning
+       || !errors[1].warning || errors[1].line != 3 || errors[1].column != 21){
+        std::printf("FAIL: [D] [Coalesce] on the wheel should parse, [Smooth] on a button be rejected and [Coalese] warned about\n");
+        ++failed;
+    }
+    return failed;
+}
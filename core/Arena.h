@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// ---- Object arena ----
+// Objects of one type placed back to back in a few large blocks, each aligned for T,
+// instead of one heap allocation apiece. Objects never move once created, and are all
+// destroyed and released together by Clear or the arena's destructor. Blocks double in
+// size as the arena fills; Reserve makes room for a known count in a single block.
+template <typename T>
+class Arena {
+public:
+    Arena() = default;
+    ~Arena(){ Clear(); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void Reserve(size_t count){
+        if(count > Room()) AddBlock(count);
+    }
+
+    T *New(){
+        if(Room() == 0) AddBlock(blocks.empty() ? kFirstBlock : blocks.back().capacity * 2);
+        Block &b = blocks.back();
+        T *obj = new (b.data + b.used) T();
+        ++b.used;
+        return obj;
+    }
+
+    size_t Size() const {
+        size_t n = 0;
+        for(const auto &b : blocks) n += b.used;
+        return n;
+    }
+
+    void Clear(){
+        for(auto &b : blocks){
+            for(size_t i = 0; i < b.used; ++i) b.data[i].~T();
+            ::operator delete(b.data, std::align_val_t(alignof(T)));
+        }
+        blocks.clear();
+    }
+
+private:
+    struct Block {
+        T *data;
+        size_t used;
+        size_t capacity;
+    };
+
+    static const size_t kFirstBlock = 8;
+
+    size_t Room() const { return blocks.empty() ? 0 : blocks.back().capacity - blocks.back().used; }
+
+    void AddBlock(size_t capacity){
+        void *data = ::operator new(capacity * sizeof(T), std::align_val_t(alignof(T)));
+        blocks.push_back(Block{ static_cast<T*>(data), 0, capacity });
+    }
+
+    std::vector<Block> blocks;
+};
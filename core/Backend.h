@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "KeyCodes.h"
+
+// ---- Backend interfaces ----
+// The engine only talks to the platform through these. Win32Backend implements them on
+// top of low-level hooks, SendInput and a high-resolution waitable timer; LinuxBackend
+// provides a timerfd clock, an inotify watcher and an evdev input source; SimBackend implements them in memory with a virtual clock
+// so the engine can run headless. Both real backends can also raise and pin threads.
+
+// Receives captured input. Returns true if the original event must be suppressed;
+// sources that cannot block input (Raw Input, evdev) ignore the answer.
+class IInputHandler {
+public:
+    virtual ~IInputHandler() = default;
+    virtual bool OnInput(const InputEvent &ev) = 0;
+};
+
+class IInputSource {
+public:
+    virtual ~IInputSource() = default;
+    virtual bool Start(IInputHandler *handler) = 0;
+    virtual void Stop() = 0;
+};
+
+class IInputSink {
+public:
+    virtual ~IInputSink() = default;
+    virtual void Send(const InjectOp *ops, size_t count) = 0;
+};
+
+class IClock {
+public:
+    static const uint64_t kForever = UINT64_MAX;
+
+    virtual ~IClock() = default;
+    virtual uint64_t NowNs() = 0;
+    virtual void SleepNs(uint64_t ns) = 0;
+    // Blocks until NowNs() >= deadlineNs or until Wake() is called from another thread
+    virtual void WaitUntil(uint64_t deadlineNs) = 0;
+    virtual void Wake() = 0;
+};
+
+// Watches one directory and reports files that changed, once their writes have settled.
+// The callback runs on the watcher's own thread with the file name relative to the directory.
+class IFileWatcher {
+public:
+    typedef std::function<void(const std::string &file)> ChangeFn;
+
+    virtual ~IFileWatcher() = default;
+    virtual bool Start(const std::string &dir, ChangeFn onChanged) = 0;
+    virtual void Stop() = 0;
+};
+
+// Reports the application that owns the foreground window each time it changes, from
+// the OS's focus events rather than polling. The callback runs on the thread that
+// called Start with the executable's file name (no directory) and the window class.
+class IForegroundWatcher {
+public:
+    typedef std::function<void(const std::string &exe, const std::string &windowClass)> ChangeFn;
+
+    virtual ~IForegroundWatcher() = default;
+    virtual bool Start(ChangeFn onChanged) = 0;
+    virtual void Stop() = 0;
+};
+
+// How a latency-critical thread is scheduled. HIGH and REALTIME are the MMCSS "Games"
+// task at high and critical priority on Windows, SCHED_FIFO at a low and a high
+// priority on Linux. cores is a mask of the CPUs the thread may run on, 0 for any.
+struct ThreadPolicy {
+    enum Priority : uint8_t { NORMAL = 0, HIGH = 1, REALTIME = 2 };
+    Priority priority = NORMAL;
+    uint64_t cores = 0;
+
+    bool operator==(const ThreadPolicy &o) const { return priority == o.priority && cores == o.cores; }
+    bool operator!=(const ThreadPolicy &o) const { return !(*this == o); }
+};
+
+// Applies a policy to the calling thread, NORMAL and 0 restoring the defaults. Returns
+// false if the OS refused any of it (SCHED_FIFO without the privilege, a core that
+// does not exist); the thread then keeps whatever part did apply.
+class IThreadTuner {
+public:
+    virtual ~IThreadTuner() = default;
+    virtual bool Apply(const ThreadPolicy &policy) = 0;
+};
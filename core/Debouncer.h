@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ---- Change debouncer ----
+// Editors save in bursts (truncate, write, rename, touch). Each Touch pushes a name's
+// deadline out by quietNs; Flush hands over the names that have been quiet since.
+// Used from a single watcher thread.
+class Debouncer {
+public:
+    static const uint64_t kNone = UINT64_MAX;
+
+    explicit Debouncer(uint64_t quietNs) : quietNs(quietNs) {}
+
+    void Touch(const std::string &name, uint64_t nowNs){
+        for(auto &p : pending){
+            if(p.name == name){ p.dueNs = nowNs + quietNs; return; }
+        }
+        pending.push_back(Pending{ name, nowNs + quietNs });
+    }
+
+    uint64_t NextDueNs() const {
+        uint64_t next = kNone;
+        for(auto &p : pending) if(p.dueNs < next) next = p.dueNs;
+        return next;
+    }
+
+    template <typename F>
+    void Flush(uint64_t nowNs, F &&fn){
+        size_t w = 0;
+        for(size_t r = 0; r < pending.size(); ++r){
+            if(pending[r].dueNs <= nowNs) fn(pending[r].name);
+            else pending[w++] = pending[r];
+        }
+        pending.resize(w);
+    }
+
+private:
+    struct Pending {
+        std::string name;
+        uint64_t dueNs;
+    };
+    uint64_t quietNs;
+    std::vector<Pending> pending;
+};
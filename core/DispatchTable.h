@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// ---- Trigger dispatch table ----
+// Flat, VK-indexed lookup built once per loaded profile. Slot v covers
+// entries[begin[v] .. begin[v+1]) and lists every macro whose trigger
+// resolves to virtual key v, so the hooks do a single array lookup and
+// bail out immediately for keys that are not bound to anything.
+struct DispatchEntry {
+    uint16_t macroIndex;
+    uint8_t  detectVK;
+};
+
+struct DispatchTable {
+    static const int kSlots = 256;
+    // Macros an index and the slot offsets can address
+    static const size_t kMaxEntries = 0xFFFF;
+
+    uint16_t begin[kSlots + 1] = {};
+    std::vector<DispatchEntry> entries;
+
+    // detectVK[i] is the pre-resolved detect code of macro i (<= 0 means "never triggers").
+    // Macros past kMaxEntries are left out rather than wrap the 16-bit offsets.
+    void Build(const int *detectVK, size_t count){
+        if(count > kMaxEntries) count = kMaxEntries;
+        entries.clear();
+        uint16_t counts[kSlots] = {};
+        for(size_t i = 0; i < count; ++i){
+            int vk = detectVK[i];
+            if(vk > 0 && vk < kSlots) ++counts[vk];
+        }
+        begin[0] = 0;
+        for(int v = 0; v < kSlots; ++v) begin[v+1] = static_cast<uint16_t>(begin[v] + counts[v]);
+        entries.resize(begin[kSlots]);
+        uint16_t fill[kSlots];
+        for(int v = 0; v < kSlots; ++v) fill[v] = begin[v];
+        // Macro order inside a slot follows file order, same as the old linear scan
+        for(size_t i = 0; i < count; ++i){
+            int vk = detectVK[i];
+            if(vk <= 0 || vk >= kSlots) continue;
+            entries[fill[vk]++] = DispatchEntry{ static_cast<uint16_t>(i), static_cast<uint8_t>(vk) };
+        }
+    }
+
+    void Clear(){
+        entries.clear();
+        for(int v = 0; v <= kSlots; ++v) begin[v] = 0;
+    }
+
+    inline bool Empty(int vk) const {
+        if(vk <= 0 || vk >= kSlots) return true;
+        return begin[vk] == begin[vk+1];
+    }
+    inline const DispatchEntry *First(int vk) const { return entries.data() + begin[vk]; }
+    inline const DispatchEntry *Last(int vk) const { return entries.data() + begin[vk+1]; }
+};
+
+static_assert(DispatchTable::kMaxEntries <= UINT16_MAX, "slot offsets and macro indexes are 16-bit");
@@ -0,0 +1,769 @@
+#include "Engine.h"
+#include "InjectTable.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+static const uint64_t DEBOUNCE_NS = 500ull * 1000000ull;
+// How often the budget's shares are redone to follow the priority traffic
+static const uint64_t kShareWindowNs = 100000000ull;
+// How soon an otherwise idle worker comes back for profiles it retired
+static const uint64_t kReclaimRetryNs = 1000000ull;
+
+Engine::Engine(IInputSink &sink, IClock &clock) : sink(sink), clock(clock) {
+    batch.reserve(64);
+    fired.reserve(64);
+}
+
+Engine::~Engine(){
+    Stop();
+    // Worker is gone: adopt whatever was published last so its held keys get released
+    AdoptPublished();
+    ReleaseAll();
+    current.store(nullptr);
+    if(profileOwned) delete profile;
+    profile = nullptr;
+    epoch.ReclaimAll();
+}
+
+static void DeleteProfile(void *p){
+    delete static_cast<Profile*>(p);
+}
+
+// ---- Profile publication ----
+// The control thread publishes with one atomic store; hooks see the new profile on
+// their next event. The worker adopts it on its next pass (releasing whatever the old
+// profile still held) and retires the old one; it is freed here on a later call once
+// no hook can still be inside it.
+void Engine::SetProfile(Profile *p){
+    {
+        std::lock_guard<std::mutex> lock(publishLock);
+        current.store(p);
+        published.push_back(Publication{ p, true });
+        reloadPending.store(true);
+    }
+    clock.Wake();
+    epoch.Reclaim();
+}
+
+void Engine::UseProfile(Profile *p){
+    {
+        std::lock_guard<std::mutex> lock(publishLock);
+        current.store(p);
+        published.push_back(Publication{ p, false });
+        reloadPending.store(true);
+    }
+    clock.Wake();
+    epoch.Reclaim();
+}
+
+void Engine::ReleaseProfile(Profile *p){
+    if(!p) return;
+    {
+        std::lock_guard<std::mutex> lock(publishLock);
+        released.push_back(p);
+        reloadPending.store(true);
+    }
+    clock.Wake();
+}
+
+size_t Engine::Reclaim(){
+    return epoch.Reclaim();
+}
+
+// Sequences and replays run the same way: started by the trigger, re-armed on the
+// deadline heap from step to step, holding keys down until stopped
+static bool IsScripted(const Macro *m){
+    return m->action == Macro::ACTION_SEQUENCE || m->action == Macro::ACTION_REPLAY;
+}
+
+// A resident profile left by the worker goes back to a clean slate for its next turn
+static void ResetRunState(Profile *p){
+    for(auto m : p->macros){
+        m->active.store(false);
+        m->bindTargetDown.store(false);
+        m->scheduled = false;
+        m->sequencePc = 0;
+        m->sequenceLoop = 0;
+        m->sequenceHeld.Clear();
+    }
+}
+
+// Worker side of a swap. Profiles published and replaced before the worker got to them
+// were never used by it; owned ones are retired straight away. A released profile the
+// worker is still on becomes the engine's and is freed when it is replaced.
+void Engine::AdoptPublished(){
+    if(!reloadPending.exchange(false)) return;
+    std::vector<Publication> incoming;
+    std::vector<Profile*> freed;
+    {
+        std::lock_guard<std::mutex> lock(publishLock);
+        incoming.swap(published);
+        freed.swap(released);
+    }
+    for(auto p : freed){
+        bool pending = false;
+        for(auto &in : incoming){
+            if(in.profile == p){
+                in.owned = true;
+                pending = true;
+            }
+        }
+        if(p == profile) profileOwned = true;
+        else if(!pending){
+            epoch.Retire(p, DeleteProfile);
+            reclaimPending = true;
+        }
+    }
+    if(incoming.empty()) return;
+    for(size_t i = 0; i + 1 < incoming.size(); ++i){
+        Profile *p = incoming[i].profile;
+        if(p && incoming[i].owned && p != profile && p != incoming.back().profile){
+            epoch.Retire(p, DeleteProfile);
+            reclaimPending = true;
+        }
+    }
+    Publication next = incoming.back();
+    if(next.profile == profile){
+        profileOwned = profileOwned || next.owned;
+        return;
+    }
+    ReloadDiff diff = MigrateState(next.profile, profileOwned);
+    if(profile){
+        if(profileOwned){
+            epoch.Retire(profile, DeleteProfile);
+            reclaimPending = true;
+        } else {
+            ResetRunState(profile);
+        }
+    }
+    profile = next.profile;
+    profileOwned = next.owned;
+    reshare = true;
+    if(onProfileAdopted) onProfileAdopted(diff);
+}
+
+// Matches the incoming macros against the running ones by definition, in order. Matched
+// macros inherit active/held state and their pending deadlines, so an unchanged
+// autoclicker keeps its phase; whatever only the old profile had is released. Stats
+// move over only when the old profile is about to be freed.
+Engine::ReloadDiff Engine::MigrateState(Profile *next, bool carryStats){
+    ReloadDiff diff;
+    std::unordered_map<std::string, std::vector<Macro*>> unmatched;
+    if(profile){
+        for(size_t i = profile->macros.size(); i-- > 0;){
+            Macro *m = profile->macros[i];
+            unmatched[m->definition].push_back(m);
+        }
+    }
+    std::unordered_map<Macro*, Macro*> moved;
+    if(next){
+        for(auto n : next->macros){
+            auto it = unmatched.find(n->definition);
+            if(it == unmatched.end() || it->second.empty()){
+                ++diff.added;
+                continue;
+            }
+            Macro *o = it->second.back();
+            it->second.pop_back();
+            n->active.store(o->active.load());
+            n->bindTargetDown.store(o->bindTargetDown.load());
+            n->scheduled = o->scheduled;
+            n->nextDueNs = o->nextDueNs;
+            n->sequencePc = o->sequencePc;
+            n->sequenceLoop = o->sequenceLoop;
+            n->sequenceHeld = o->sequenceHeld;
+            n->replayOriginNs = o->replayOriginNs;
+            n->firePeriodNs = o->firePeriodNs;
+            n->wheelUnits = o->wheelUnits;
+            n->wheelCarry = o->wheelCarry;
+            if(carryStats) n->stats.Merge(o->stats);
+            moved[o] = n;
+            ++diff.kept;
+        }
+    }
+    diff.removed = (profile ? profile->macros.size() : 0) - diff.kept;
+
+    std::vector<DeadlineHeap<Deadline>::Entry> carried;
+    while(!deadlines.Empty()){
+        DeadlineHeap<Deadline>::Entry e = deadlines.Pop();
+        auto it = moved.find(e.item.macro);
+        if(it != moved.end()){
+            e.item.macro = it->second;
+            carried.push_back(e);
+        } else if(e.item.kind == Deadline::RELEASE){
+            Macro *m = e.item.macro;
+            batch.insert(batch.end(), &m->ops[1], &m->ops[1] + m->upCount);
+        }
+    }
+    for(auto &e : carried) deadlines.Push(e.dueNs, e.item);
+
+    if(profile){
+        for(auto m : profile->macros){
+            if(moved.count(m)) continue;
+            if(m->action == Macro::ACTION_BIND && m->bindTargetDown.load()){
+                batch.insert(batch.end(), &m->ops[1], &m->ops[1] + m->upCount);
+                m->bindTargetDown.store(false);
+            }
+            if(IsScripted(m)) StopSequence(m);
+        }
+    }
+    FlushBatch();
+    return diff;
+}
+
+void Engine::Start(){
+    if(running.exchange(true)) return;
+    worker = std::thread(&Engine::WorkerLoop, this);
+}
+
+void Engine::Stop(){
+    if(!running.exchange(false)) return;
+    clock.Wake();
+    if(worker.joinable()) worker.join();
+}
+
+// Brings the calling thread to the policy of the profile in force when that changed
+static void TuneThread(IThreadTuner *tuner, ThreadPolicy &applied, const ThreadPolicy &wanted, std::atomic<uint32_t> &failures){
+    if(!tuner || applied == wanted) return;
+    if(!tuner->Apply(wanted)) failures.fetch_add(1, std::memory_order_relaxed);
+    applied = wanted;
+}
+
+// The input thread only pays for a Wake when the worker is actually asleep. Both sides
+// publish (ring push / sleeping flag) before checking the other, so an event pushed
+// while the worker is going to sleep is always seen by one of them.
+void Engine::WorkerLoop(){
+    while(running.load()){
+        uint64_t next = RunDue(clock.NowNs());
+        TuneThread(threadTuner, workerPolicy, profile ? profile->injectPolicy : ThreadPolicy(), workerPolicyFailures);
+        if(!running.load()) break;
+        workerSleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(ring.Empty()) clock.WaitUntil(next);
+        workerSleeping.store(false);
+    }
+    TuneThread(threadTuner, workerPolicy, ThreadPolicy(), workerPolicyFailures);
+}
+
+void Engine::SetPaused(bool paused){
+    isPaused.store(paused);
+    clock.Wake();
+}
+
+// Worker side of a pause change: stop every autoclicker and sequence and report it
+void Engine::ApplyPause(bool paused){
+    workerPaused = paused;
+    if(paused && profile){
+        for(auto m : profile->macros){
+            if(m->action == Macro::ACTION_AUTOCLICK){
+                m->active.store(false);
+            } else if(IsScripted(m)){
+                StopSequence(m);
+            }
+        }
+    }
+    if(onPauseChanged) onPauseChanged(paused);
+}
+
+// ---- Injection ----
+// Appends count autoclicks to the pass's batch. Mouse clicks go out as down+up together;
+// a keyboard key is held for keyHoldNs via a scheduled release rather than a sleep.
+// Clicks owed from a late wakeup go out first as tight pairs.
+void Engine::QueueClicks(Macro *m, uint64_t count, uint64_t now){
+    const InjectOp *click = m->ops;
+    size_t n = m->downCount + m->upCount;
+    if(m->keyboardTarget){
+        for(uint64_t i = 1; i < count; ++i) batch.insert(batch.end(), click, click + n);
+        batch.insert(batch.end(), click, click + m->downCount);
+        uint64_t hold = m->periodNs / 2 < keyHoldNs ? m->periodNs / 2 : keyHoldNs;
+        deadlines.Push(now + hold, Deadline{ m, Deadline::RELEASE });
+        return;
+    }
+    for(uint64_t i = 0; i < count; ++i) batch.insert(batch.end(), click, click + n);
+}
+
+// Time between the fires of an autoclicker. A [Coalesce] wheel fires on whole multiples
+// of its period, so each fire scrolls whole notches; a [Smooth] one on the window itself.
+static uint64_t FirePeriod(const Macro *m, uint64_t windowNs){
+    if(m->wheelMode == Macro::WHEEL_SMOOTH && windowNs > 0) return windowNs;
+    if(m->wheelMode == Macro::WHEEL_COALESCE && m->periodNs < windowNs) return windowNs / m->periodNs * m->periodNs;
+    return m->periodNs;
+}
+
+// Sends the distance a coalescing wheel owes since its last fire as a single event,
+// added to the one another coalescing wheel already put in the batch for the same
+// direction. Fires follow an absolute timeline like any autoclick, with the same
+// catch-up window; the fraction of a notch [Smooth] could not send yet carries over.
+void Engine::FireWheel(Macro *m, uint64_t now){
+    uint64_t step = m->firePeriodNs;
+    uint64_t owed = (now - m->nextDueNs) / step + 1;
+    uint64_t window = catchUpNs > step ? catchUpNs / step : 1;
+    uint64_t skipped = owed > window ? owed - window : 0;
+    if(skipped){
+        missedTicks.fetch_add(skipped);
+        m->stats.missed.fetch_add(skipped, std::memory_order_relaxed);
+    }
+    uint64_t due = m->nextDueNs + skipped * step;
+    m->nextDueNs += owed * step;
+    deadlines.Push(m->nextDueNs, Deadline{ m, Deadline::FIRE });
+    m->stats.fires.fetch_add(1, std::memory_order_relaxed);
+
+    m->wheelCarry += (owed - skipped) * step * static_cast<uint64_t>(kWheelDelta);
+    uint64_t units = m->wheelCarry / m->periodNs;
+    m->wheelCarry %= m->periodNs;
+    if(units == 0) return;
+    uint64_t notches = (m->wheelUnits + units) / kWheelDelta - m->wheelUnits / kWheelDelta;
+    m->wheelUnits += units;
+    if(Admit(m, 1, now) == 0){
+        throttledClicks.fetch_add(notches);
+        m->stats.throttled.fetch_add(notches, std::memory_order_relaxed);
+        return;
+    }
+    int32_t delta = units > INT32_MAX ? INT32_MAX : static_cast<int32_t>(units);
+    bool down = m->ops[0].mouseData < 0;
+    size_t &slot = wheelOps[down];
+    if(slot < batch.size()){
+        int64_t sum = static_cast<int64_t>(batch[slot].mouseData) + (down ? -delta : delta);
+        batch[slot].mouseData = static_cast<int32_t>(sum < INT32_MIN ? INT32_MIN : sum > INT32_MAX ? INT32_MAX : sum);
+    } else {
+        slot = batch.size();
+        batch.push_back(InjectOp{ InjectOp::MOUSE, 0, kMouseWheel, down ? -delta : delta });
+        ++clickOps;
+    }
+    fired.push_back(DeadlineHeap<Macro*>::Entry{ due, m });
+    m->stats.clicks.fetch_add(notches, std::memory_order_relaxed);
+}
+
+// Runs a sequence from its pc up to the next wait, which re-arms it on the deadline heap,
+// or to the end of its program. Waits advance an absolute timeline so steps do not drift;
+// after a stall longer than catchUpNs the timeline restarts from now instead of rushing
+// the remaining steps out together.
+void Engine::RunSequence(Macro *m, uint64_t now){
+    const SeqOp *program = profile->sequenceOps.data() + m->sequenceBegin;
+    fired.push_back(DeadlineHeap<Macro*>::Entry{ m->nextDueNs, m });
+    m->stats.fires.fetch_add(1, std::memory_order_relaxed);
+    if(now - m->nextDueNs > catchUpNs){
+        missedTicks.fetch_add(1);
+        m->stats.missed.fetch_add(1, std::memory_order_relaxed);
+        m->nextDueNs = now;
+    }
+    for(;;){
+        if(m->sequencePc == m->sequenceLength){
+            if(m->runOnce || !m->active.load()){
+                StopSequence(m);
+                return;
+            }
+            m->sequencePc = 0;
+            m->sequenceLoop = 0;
+        }
+        const SeqOp &op = program[m->sequencePc++];
+        InjectTemplate t = TemplateForConfigCode(op.key);
+        switch(op.code){
+            case SeqOp::DOWN:
+                batch.push_back(t.down);
+                if(t.upCount) m->sequenceHeld.Set(op.key);
+                m->stats.clicks.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case SeqOp::UP:
+                if(t.upCount) batch.push_back(t.up);
+                m->sequenceHeld.Reset(op.key);
+                break;
+            case SeqOp::CLICK:
+                batch.push_back(t.down);
+                if(t.upCount) batch.push_back(t.up);
+                m->stats.clicks.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case SeqOp::WAIT:
+                m->nextDueNs += op.arg;
+                deadlines.Push(m->nextDueNs, Deadline{ m, Deadline::FIRE });
+                return;
+            case SeqOp::REPEAT:
+                if(++m->sequenceLoop < op.arg) m->sequencePc = op.key;
+                else m->sequenceLoop = 0;
+                break;
+        }
+    }
+}
+
+// Sends every event of a replay due by now, then re-arms it for the next one. Events
+// are due at the pass's origin plus their recorded time, an absolute timeline, so
+// spacing never drifts; how late each one actually goes out is recorded as the
+// macro's lateness, which is the replay error. A looping replay starts its next pass
+// where the last event of this one was due. After a stall longer than catchUpNs the
+// timeline shifts to now instead of rushing the late events out together.
+void Engine::RunReplay(Macro *m, uint64_t now){
+    const TraceData *trace = m->trace;
+    for(;;){
+        if(!trace || m->sequencePc >= trace->count){
+            // A trace with all its events at one instant would loop without end
+            if(!trace || m->runOnce || !m->active.load() || trace->DurationNs() == 0){
+                StopSequence(m);
+                return;
+            }
+            m->replayOriginNs += trace->DurationNs();
+            m->sequencePc = 0;
+        }
+        const TraceRecord &r = trace->records[m->sequencePc];
+        uint64_t due = m->replayOriginNs + r.timeNs;
+        if(due > now){
+            m->nextDueNs = due;
+            deadlines.Push(due, Deadline{ m, Deadline::FIRE });
+            return;
+        }
+        ++m->sequencePc;
+        if(now - due > catchUpNs){
+            missedTicks.fetch_add(1);
+            m->stats.missed.fetch_add(1, std::memory_order_relaxed);
+            m->replayOriginNs += now - due;
+            due = now;
+        }
+        fired.push_back(DeadlineHeap<Macro*>::Entry{ due, m });
+        m->stats.fires.fetch_add(1, std::memory_order_relaxed);
+        if(r.kind == TraceRecord::WHEEL){
+            batch.push_back(InjectOp{ InjectOp::MOUSE, 0, kMouseWheel, r.wheel });
+            m->stats.clicks.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        // Buttons go through their config codes, so held keys and buttons share one set
+        int key = r.vk;
+        if(r.kind == TraceRecord::BUTTON){
+            if(key == kVkLButton) key = kCfgLmb;
+            else if(key == kVkRButton) key = kCfgRmb;
+            else if(key != kVkMButton && key != kVkXButton1 && key != kVkXButton2) continue;
+        } else if(r.kind != TraceRecord::KEY || key <= kCfgMouseX2 || key >= kCfgRmb){
+            // Codes that stand for mouse actions in a profile cannot be replayed as keys
+            continue;
+        }
+        InjectTemplate t = TemplateForConfigCode(key);
+        if(r.down){
+            batch.push_back(t.down);
+            m->sequenceHeld.Set(key);
+            m->stats.clicks.fetch_add(1, std::memory_order_relaxed);
+        } else if(m->sequenceHeld.Test(key)){
+            // A release of something pressed before the recording began is not ours to send
+            batch.push_back(t.up);
+            m->sequenceHeld.Reset(key);
+        }
+    }
+}
+
+// Releases every key a sequence or replay still holds down and ends its run. A deadline it left
+// on the heap is recognised as stale when popped and dropped.
+void Engine::StopSequence(Macro *m){
+    for(int w = 0; w < 4; ++w){
+        uint64_t bits = m->sequenceHeld.bits[w];
+        for(int key = w * 64; bits; ++key, bits >>= 1){
+            if(bits & 1) batch.push_back(TemplateForConfigCode(key).up);
+        }
+    }
+    m->sequenceHeld.Clear();
+    m->active.store(false);
+    m->sequencePc = 0;
+    m->sequenceLoop = 0;
+    if(m->scheduled) EndRun(m);
+}
+
+// Sends the release of every key still held by a pending autoclick release or a bind
+void Engine::ReleaseAll(){
+    while(!deadlines.Empty()){
+        Deadline d = deadlines.Pop().item;
+        if(d.kind == Deadline::RELEASE) batch.insert(batch.end(), &d.macro->ops[1], &d.macro->ops[1] + d.macro->upCount);
+        else EndRun(d.macro);
+    }
+    if(profile){
+        for(auto m : profile->macros){
+            if(m->action == Macro::ACTION_BIND && m->bindTargetDown.load()){
+                batch.insert(batch.end(), &m->ops[1], &m->ops[1] + m->upCount);
+                m->bindTargetDown.store(false);
+            }
+            if(IsScripted(m)) StopSequence(m);
+        }
+    }
+    FlushBatch();
+}
+
+// Submission time is what the stats call "actual": lateness is measured up to the
+// moment the batch is handed to the sink, plus one more clock read for the Send itself
+void Engine::FlushBatch(){
+    if(batch.empty()) return;
+    uint64_t t0 = clock.NowNs();
+    for(auto &f : fired){
+        MacroStats &st = f.item->stats;
+        st.lateness.Record(t0 > f.dueNs ? t0 - f.dueNs : 0);
+        st.activeNs.store(st.activeBaseNs + (t0 - st.runStartNs), std::memory_order_relaxed);
+    }
+    fired.clear();
+    sink.Send(batch.data(), batch.size());
+    sendDuration.Record(clock.NowNs() - t0);
+    wheelOps[0] = wheelOps[1] = SIZE_MAX;
+    if(budget.Limited()){
+        budget.Take(batch.size());
+        priorityOps += batch.size() - clickOps;
+    }
+    clickOps = 0;
+    batch.clear();
+}
+
+void Engine::EndRun(Macro *m){
+    m->scheduled = false;
+    if(m->action == Macro::ACTION_AUTOCLICK) reshare = true;
+    m->stats.activeBaseNs = m->stats.activeNs.load(std::memory_order_relaxed);
+}
+
+// ---- Worker: injection budget ----
+// Burst allowance of a rate: what it accrues over a window, plus an event of slack so
+// that what accrues between two fires is not lost to a full bucket, and never less
+// than that over one two-event click. Shares may burst over the catch-up window; the
+// budget as a whole over a tenth of a share window, so that shares adding up to all
+// of it do not starve each other on phase alone.
+static uint64_t BudgetBurst(uint64_t rate, uint64_t windowNs){
+    uint64_t burst = rate * windowNs / 1000000000ull;
+    return (burst > 2 ? burst : 2) + 1;
+}
+
+// Splits the profile's [Budget] among the running autoclickers, max-min fair: one that
+// wants less than an equal split keeps its full rate and what it leaves over goes to
+// the rest. Binds, sequences and replays are never held back. What they sent over the
+// last share window is set aside before the split, and as everything sent is drawn
+// from the one bucket, a burst beyond that still makes the autoclickers wait.
+void Engine::ShareBudget(uint64_t now){
+    reshare = false;
+    if(now - shareWindowNs >= kShareWindowNs){
+        priorityRate = priorityOps * 1000000000ull / (now - shareWindowNs);
+        priorityOps = 0;
+        shareWindowNs = now;
+    }
+    uint64_t rate = profile ? profile->injectBudget : 0;
+    budget.SetRate(rate, BudgetBurst(rate, kShareWindowNs / 10), now);
+    sharing.clear();
+    if(profile){
+        for(auto m : profile->macros){
+            if(m->action == Macro::ACTION_AUTOCLICK && m->scheduled) sharing.push_back(m);
+        }
+    }
+    // Events per second a macro sends when nothing holds it back
+    auto demand = [](const Macro *m){
+        uint64_t events = m->wheelMode != Macro::WHEEL_EACH ? 1 : m->downCount + m->upCount;
+        return 1e9 * static_cast<double>(events) / static_cast<double>(m->firePeriodNs);
+    };
+    std::sort(sharing.begin(), sharing.end(), [&](const Macro *a, const Macro *b){ return demand(a) < demand(b); });
+    double left = static_cast<double>(rate > priorityRate ? rate - priorityRate : 0);
+    for(size_t i = 0; i < sharing.size(); ++i){
+        Macro *m = sharing[i];
+        double fair = left / static_cast<double>(sharing.size() - i);
+        double want = demand(m);
+        if(rate == 0 || want <= fair){
+            m->share.SetRate(0, 0, now);
+            left -= want;
+            continue;
+        }
+        uint64_t share = fair >= 1.0 ? static_cast<uint64_t>(fair) : 1;
+        m->share.SetRate(share, BudgetBurst(share, catchUpNs), now);
+        left -= fair;
+    }
+}
+
+// How many of count clicks m may send now: within its share, and within what the
+// budget has left after the events already in this pass's batch
+uint64_t Engine::Admit(Macro *m, uint64_t count, uint64_t now){
+    uint64_t cost = m->downCount + m->upCount;
+    if(!budget.Limited() || cost == 0) return count;
+    uint64_t room = budget.Available();
+    room = room > batch.size() ? room - batch.size() : 0;
+    if(m->share.Limited()){
+        m->share.Refill(now);
+        room = std::min(room, m->share.Available());
+    }
+    uint64_t n = std::min(count, room / cost);
+    m->share.Take(n * cost);
+    return n;
+}
+
+// ---- Worker: macro state ----
+void Engine::HandleInput(const InputEvent &ev, uint64_t now){
+    const DispatchTable &dispatch = profile->dispatch;
+    if(dispatch.Empty(ev.vk)) return;
+    int best = ev.down ? HeldChordSize(*profile, ev.vk, workerPressed) : 0;
+    for(const DispatchEntry *e = dispatch.First(ev.vk), *end = dispatch.Last(ev.vk); e != end; ++e){
+        Macro *m = profile->macros[e->macroIndex];
+        if(ev.down && (!workerPressed.Contains(m->chord) || m->chord.Count() != best)) continue;
+        if(m->action == Macro::ACTION_AUTOCLICK){
+            bool was = m->active.load();
+            bool on = m->clickHold ? ev.down : (ev.down ? !was : was);
+            m->active.store(on);
+            if(on && !m->scheduled && m->periodNs > 0){
+                m->scheduled = true;
+                reshare = true;
+                m->stats.runStartNs = now;
+                m->firePeriodNs = FirePeriod(m, wheelWindowNs);
+                m->wheelUnits = 0;
+                m->wheelCarry = 0;
+                m->nextDueNs = now + m->firePeriodNs;
+                deadlines.Push(m->nextDueNs, Deadline{ m, Deadline::FIRE });
+            }
+        } else if(IsScripted(m)){
+            // A run-once sequence or replay ignores its trigger until the run ends
+            bool was = m->active.load();
+            bool on = m->runOnce ? (was || ev.down) : m->clickHold ? ev.down : (ev.down ? !was : was);
+            if(on && !was){
+                m->active.store(true);
+                m->scheduled = true;
+                m->sequencePc = 0;
+                m->sequenceLoop = 0;
+                m->replayOriginNs = now;
+                m->stats.runStartNs = now;
+                m->nextDueNs = now;
+                deadlines.Push(now, Deadline{ m, Deadline::FIRE });
+            } else if(!on && was){
+                StopSequence(m);
+            }
+        } else if(m->action == Macro::ACTION_BIND){
+            if(ev.down){
+                if(!m->bindTargetDown.load()){
+                    batch.insert(batch.end(), &m->ops[0], &m->ops[0] + m->downCount);
+                    m->bindTargetDown.store(true);
+                    m->stats.clicks.fetch_add(1, std::memory_order_relaxed);
+                }
+            } else {
+                if(m->bindTargetDown.load()){
+                    batch.insert(batch.end(), &m->ops[1], &m->ops[1] + m->upCount);
+                    m->bindTargetDown.store(false);
+                }
+            }
+        }
+    }
+}
+
+// ---- Worker: scheduler ----
+uint64_t Engine::RunDue(uint64_t now){
+    // What the previous passes retired is freed here, once hooks that were inside the
+    // old profile have had a pass to leave it
+    if(reclaimPending) reclaimPending = epoch.Reclaim() != 0;
+    AdoptPublished();
+
+    bool paused = isPaused.load();
+    if(paused != workerPaused) ApplyPause(paused);
+
+    InputEvent ev;
+    while(ring.TryPop(ev)){
+        processedEvents.fetch_add(1, std::memory_order_relaxed);
+        UpdatePressed(workerPressed, ev.vk, ev.down);
+        if(profile && !paused) HandleInput(ev, now);
+    }
+    if(!profile){
+        FlushBatch();
+        return reclaimPending ? now + kReclaimRetryNs : IClock::kForever;
+    }
+    budget.Refill(now);
+    if(reshare || (budget.Limited() && now - shareWindowNs >= kShareWindowNs)) ShareBudget(now);
+
+    // Everything due at this instant, across all macros, leaves in one Send
+    while(!deadlines.Empty() && deadlines.NextDue() <= now){
+        DeadlineHeap<Deadline>::Entry e = deadlines.Pop();
+        Macro *m = e.item.macro;
+        if(e.item.kind == Deadline::RELEASE){
+            batch.insert(batch.end(), &m->ops[1], &m->ops[1] + m->upCount);
+            clickOps += m->upCount;
+            continue;
+        }
+        if(IsScripted(m)){
+            // Left behind by a sequence or replay that was stopped or restarted since
+            if(!m->scheduled || e.dueNs != m->nextDueNs) continue;
+            if(m->action == Macro::ACTION_REPLAY) RunReplay(m, now);
+            else RunSequence(m, now);
+            continue;
+        }
+        if(paused || !m->active.load()){
+            EndRun(m);
+            continue;
+        }
+        if(m->wheelMode != Macro::WHEEL_EACH){
+            FireWheel(m, now);
+            continue;
+        }
+        // One click is owed per slot of the macro's absolute timeline up to now. Clicks
+        // are due one period apart, so at any interval the long-run rate is exact and a
+        // wakeup normally owes one; a late wakeup sends what it owes within the catch-up
+        // window and skips older slots rather than bursting the backlog out.
+        uint64_t owed = (now - m->nextDueNs) / m->periodNs + 1;
+        uint64_t window = catchUpNs > m->periodNs ? catchUpNs / m->periodNs : 1;
+        uint64_t skipped = owed > window ? owed - window : 0;
+        if(skipped){
+            missedTicks.fetch_add(skipped);
+            m->stats.missed.fetch_add(skipped, std::memory_order_relaxed);
+        }
+        uint64_t due = owed - skipped;
+        uint64_t sent = Admit(m, due, now);
+        if(sent < due){
+            throttledClicks.fetch_add(due - sent);
+            m->stats.throttled.fetch_add(due - sent, std::memory_order_relaxed);
+        }
+        if(sent){
+            size_t queued = batch.size();
+            QueueClicks(m, sent, now);
+            clickOps += batch.size() - queued;
+            fired.push_back(DeadlineHeap<Macro*>::Entry{ m->nextDueNs + skipped * m->periodNs, m });
+        }
+        m->stats.fires.fetch_add(1, std::memory_order_relaxed);
+        m->stats.clicks.fetch_add(sent, std::memory_order_relaxed);
+        m->nextDueNs += owed * m->periodNs;
+        deadlines.Push(m->nextDueNs, Deadline{ m, Deadline::FIRE });
+    }
+    FlushBatch();
+    uint64_t next = deadlines.Empty() ? IClock::kForever : deadlines.NextDue();
+    return reclaimPending ? std::min(next, now + kReclaimRetryNs) : next;
+}
+
+// ---- Input thread ----
+// The hook keeps its own pressed-key set. Chords are matched against it with a mask
+// compare, and only on keys that have a chord macro, so unbound keys still cost one
+// table lookup. A release is swallowed exactly when its press was.
+bool Engine::OnInput(const InputEvent &ev){
+    // Nothing triggers on the wheel; sources report it for recording only
+    if(ev.wheel) return false;
+    int vk = ev.vk;
+    UpdatePressed(pressed, vk, ev.down);
+
+    bool suppress = false;
+    epoch.Enter(kInputReader);
+    const Profile *p = current.load();
+    TuneThread(threadTuner, inputPolicy, p ? p->capturePolicy : ThreadPolicy(), inputPolicyFailures);
+    const KeySet &pauseChord = p ? p->pauseChord : defaultPauseChord;
+    if(ev.down && pauseChord.Test(vk) && pressed.Contains(pauseChord)
+       && ev.timeNs - lastPauseToggleNs > DEBOUNCE_NS){
+        lastPauseToggleNs = ev.timeNs;
+        SetPaused(!isPaused.load());
+        suppress = true;
+    } else if(!ev.down){
+        suppress = suppressedDown.Test(vk);
+    }
+    // Chord keys reach the worker even while paused so its pressed set stays true
+    if(p){
+        bool bound = !isPaused.load() && !p->dispatch.Empty(vk);
+        if(bound || p->chordKeys.Test(vk)){
+            if(ring.TryPush(ev)){
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if(workerSleeping.load()) clock.Wake();
+            } else {
+                ringOverflows.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if(bound && ev.down && !suppress){
+            suppress = p->suppress[vk] == kSuppressAlways;
+            if(p->suppress[vk] == kSuppressChord){
+                int best = HeldChordSize(*p, vk, pressed);
+                for(const DispatchEntry *e = p->dispatch.First(vk), *end = p->dispatch.Last(vk); e != end && !suppress; ++e){
+                    const Macro *m = p->macros[e->macroIndex];
+                    suppress = pressed.Contains(m->chord) && m->chord.Count() == best && ShouldSuppressOriginal(m);
+                }
+            }
+        }
+    }
+    if(ev.down) suppressedDown.Assign(vk, suppress);
+    else suppressedDown.Reset(vk);
+    epoch.Exit(kInputReader);
+    hookResidency.Record(clock.NowNs() - ev.timeNs);
+    return suppress;
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Backend.h"
+#include "Profile.h"
+#include "Scheduler.h"
+#include "TokenBucket.h"
+#include "EventRing.h"
+#include "LatencyHistogram.h"
+#include "Epoch.h"
+
+// ---- Macro engine ----
+// Platform-independent trigger handling and autoclick timing, split over two threads:
+//  - OnInput runs inside the input source (the OS hook). It only decides suppress or
+//    pass-through from the published profile's precomputed table and pushes the event
+//    into a lock-free ring.
+//  - The worker (RunDue, on the engine's own thread via Start or driven directly on a
+//    virtual clock) drains the ring, updates macro state, services the deadline heap
+//    of active autoclickers and submits everything due as one batch. Logging
+//    callbacks also run here, never in the hook.
+class Engine : public IInputHandler {
+public:
+    Engine(IInputSink &sink, IClock &clock);
+    ~Engine();
+
+    // Publishes a fully built profile and takes ownership of it. Never blocks the input
+    // or worker threads; the replaced profile is freed by the worker a pass or so after
+    // it switches, or by a later SetProfile/Reclaim. SetProfile, Reclaim and GetProfile
+    // belong to a single control thread.
+    void SetProfile(Profile *profile);
+    // Publishes a profile that stays owned by the caller (a ProfileRegistry entry), so
+    // switching between resident profiles is the same swap with nothing to free. Each
+    // keeps its own stats; its run state is reset when the worker switches away from it.
+    void UseProfile(Profile *profile);
+    // Hands a profile passed to UseProfile back to the engine, which frees it once
+    // neither thread can still be using it. Release a profile before publishing its
+    // replacement and the replacement inherits its stats, as with SetProfile.
+    void ReleaseProfile(Profile *profile);
+    const Profile *GetProfile() const { return current.load(); }
+    size_t MacroCount() const { const Profile *p = current.load(); return p ? p->macros.size() : 0; }
+    // Frees retired profiles that no hook can still be using; returns how many remain
+    size_t Reclaim();
+    // Retired profiles not freed yet
+    size_t RetiredProfiles(){ return epoch.Pending(); }
+
+    void SetPaused(bool paused);
+    bool IsPaused() const { return isPaused.load(); }
+
+    bool OnInput(const InputEvent &ev) override;
+
+    // Processes queued input and fires every click due at or before nowNs; returns the
+    // next deadline (IClock::kForever if idle)
+    uint64_t RunDue(uint64_t nowNs);
+
+    // Runs RunDue on a dedicated worker thread that sleeps on the clock between deadlines
+    void Start();
+    void Stop();
+
+    // Macros carried over, created and dropped when the worker adopted a new profile
+    struct ReloadDiff {
+        size_t kept = 0;
+        size_t added = 0;
+        size_t removed = 0;
+    };
+
+    // Called from the worker thread whenever pause state changes (chord or SetPaused)
+    std::function<void(bool paused)> onPauseChanged;
+    // Called from the worker thread after it switched to a newly published profile
+    std::function<void(const ReloadDiff &diff)> onProfileAdopted;
+
+    // How long an autoclicked keyboard key is held before its release (capped at half the period)
+    uint64_t keyHoldNs = 1000000;
+
+    // How far behind its timeline a macro may fall and still have the clicks it owes sent
+    // (late, in one batch); older slots are skipped. Never less than one period.
+    uint64_t catchUpNs = 1000000;
+
+    // How often a [Smooth] wheel autoclicker fires, and the least time between the fires
+    // of a [Coalesce] one, which sends the notches owed since as one event
+    uint64_t wheelWindowNs = 1000000;
+
+    // Applies each profile's [Priority] and [Cores], if set (before Start): the worker to
+    // itself when it adopts the profile, the input thread on its first event under it
+    IThreadTuner *threadTuner = nullptr;
+    // Policy changes the OS refused, typically realtime without the privilege for it
+    std::atomic<uint32_t> workerPolicyFailures{0};
+    std::atomic<uint32_t> inputPolicyFailures{0};
+
+    // Timeline slots older than the catch-up window, skipped instead of sent as a burst
+    std::atomic<uint64_t> missedTicks{0};
+    // Autoclicks dropped to keep within the profile's [Budget]
+    std::atomic<uint64_t> throttledClicks{0};
+    // Input events lost because the ring was full, and events the worker has handled
+    std::atomic<uint64_t> ringOverflows{0};
+    std::atomic<uint64_t> processedEvents{0};
+    // Time from the input source timestamping an event to OnInput returning
+    LatencyHistogram hookResidency;
+    // Duration of each sink.Send call (one per worker pass that injects anything)
+    LatencyHistogram sendDuration;
+
+private:
+    struct Deadline {
+        enum Kind : uint8_t { FIRE, RELEASE };
+        Macro *macro;
+        Kind kind;
+    };
+
+    static const int kInputReader = 0;
+
+    void WorkerLoop();
+    void AdoptPublished();
+    ReloadDiff MigrateState(Profile *next, bool carryStats);
+    void ApplyPause(bool paused);
+    void HandleInput(const InputEvent &ev, uint64_t now);
+    void QueueClicks(Macro *m, uint64_t count, uint64_t now);
+    void FireWheel(Macro *m, uint64_t now);
+    void RunSequence(Macro *m, uint64_t now);
+    void RunReplay(Macro *m, uint64_t now);
+    void StopSequence(Macro *m);
+    void ReleaseAll();
+    void FlushBatch();
+    void EndRun(Macro *m);
+    void ShareBudget(uint64_t now);
+    uint64_t Admit(Macro *m, uint64_t count, uint64_t now);
+
+    IInputSink &sink;
+    IClock &clock;
+    // Published profile, read by the input thread inside an epoch
+    std::atomic<Profile*> current{nullptr};
+    EpochDomain epoch;
+    std::mutex publishLock;
+    struct Publication {
+        Profile *profile;
+        bool owned;
+    };
+    std::vector<Publication> published;
+    std::vector<Profile*> released;
+    std::atomic_bool reloadPending{false};
+    // Profile the worker has adopted, and whether the engine frees it; worker thread only
+    Profile *profile = nullptr;
+    bool profileOwned = true;
+    // The worker retired a profile and has not seen it freed yet
+    bool reclaimPending = false;
+    EventRing<InputEvent, 1024> ring;
+    DeadlineHeap<Deadline> deadlines;
+    std::vector<InjectOp> batch;
+    // Where in the batch coalescing wheel autoclickers scroll up and down, if they do yet
+    size_t wheelOps[2] = { SIZE_MAX, SIZE_MAX };
+    // Fires in the current batch with their due times, for the lateness stats
+    std::vector<DeadlineHeap<Macro*>::Entry> fired;
+    std::atomic_bool running{false};
+    std::thread worker;
+    std::atomic_bool workerSleeping{false};
+    std::atomic_bool isPaused{false};
+    bool workerPaused = false;
+    // The profile's [Budget] over everything injected, and the running autoclickers it
+    // is shared among, redone whenever one starts or stops and once per share window
+    TokenBucket budget;
+    std::vector<Macro*> sharing;
+    bool reshare = false;
+    // Autoclick events in the current batch; the rest of a batch is priority traffic,
+    // counted over each share window and set aside from the budget for the next
+    uint64_t clickOps = 0;
+    uint64_t priorityOps = 0;
+    uint64_t priorityRate = 0;
+    uint64_t shareWindowNs = 0;
+    // Policies last applied to the worker and to the input thread, each by its own thread
+    ThreadPolicy workerPolicy;
+    ThreadPolicy inputPolicy;
+
+    // Keys held as seen by the hook, and keys whose press it swallowed; input thread only
+    KeySet pressed;
+    KeySet suppressedDown;
+    KeySet defaultPauseChord = DefaultPauseChord();
+    uint64_t lastPauseToggleNs = 0;
+    // Keys held as seen by the worker, for chord matching on dispatch
+    KeySet workerPressed;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// ---- Epoch-based reclamation ----
+// Readers bracket every access to a shared object with Enter/Exit on their own slot;
+// this costs two stores and never blocks. A writer that has unpublished an object
+// Retires it, and Reclaim frees it once every reader has been idle or has started a
+// new critical section since. Retire and Reclaim are rare (profile swaps) and may take
+// a short lock; the reader path never does.
+class EpochDomain {
+public:
+    static const int kMaxReaders = 4;
+    static const uint64_t kIdle = UINT64_MAX;
+
+    typedef void (*Deleter)(void *);
+
+    ~EpochDomain(){ ReclaimAll(); }
+
+    void Enter(int slot){
+        readers[slot].epoch.store(global.load());
+    }
+    void Exit(int slot){
+        readers[slot].epoch.store(kIdle, std::memory_order_release);
+    }
+
+    // The object must already be unreachable for readers entering from now on
+    void Retire(void *p, Deleter del){
+        uint64_t e = global.fetch_add(1) + 1;
+        std::lock_guard<std::mutex> lock(retiredLock);
+        retired.push_back(Retired{ p, del, e });
+    }
+
+    // Frees every retired object no reader can still see; returns how many remain
+    size_t Reclaim(){
+        uint64_t oldest = kIdle;
+        for(int i = 0; i < kMaxReaders; ++i){
+            uint64_t e = readers[i].epoch.load();
+            if(e < oldest) oldest = e;
+        }
+        std::vector<Retired> ready;
+        {
+            std::lock_guard<std::mutex> lock(retiredLock);
+            size_t w = 0;
+            for(size_t r = 0; r < retired.size(); ++r){
+                if(retired[r].epoch <= oldest) ready.push_back(retired[r]);
+                else retired[w++] = retired[r];
+            }
+            retired.resize(w);
+        }
+        for(auto &r : ready) r.del(r.p);
+        std::lock_guard<std::mutex> lock(retiredLock);
+        return retired.size();
+    }
+
+    size_t Pending(){
+        std::lock_guard<std::mutex> lock(retiredLock);
+        return retired.size();
+    }
+
+    // Only safe once no reader can be active any more (shutdown)
+    void ReclaimAll(){
+        std::lock_guard<std::mutex> lock(retiredLock);
+        for(auto &r : retired) r.del(r.p);
+        retired.clear();
+    }
+
+private:
+    struct alignas(64) Reader {
+        std::atomic<uint64_t> epoch{kIdle};
+    };
+    struct Retired {
+        void *p;
+        Deleter del;
+        uint64_t epoch;
+    };
+
+    alignas(64) std::atomic<uint64_t> global{1};
+    Reader readers[kMaxReaders];
+    std::mutex retiredLock;
+    std::vector<Retired> retired;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// ---- SPSC event ring ----
+// Bounded single-producer / single-consumer queue. The producer (input thread) and
+// consumer (engine worker) indices live on separate cache lines; neither side ever
+// blocks or allocates. N must be a power of two.
+template <typename T, size_t N>
+class EventRing {
+    static_assert((N & (N - 1)) == 0, "EventRing capacity must be a power of two");
+
+public:
+    bool TryPush(const T &v){
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == N) return false;
+        slots[t & (N - 1)] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T &v){
+        size_t h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire)) return false;
+        v = slots[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) T slots[N];
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// ---- FNV-1a ----
+// Content hash for cache keys; chain calls by passing the previous result as seed.
+static const uint64_t kFnvOffset = 1469598103934665603ull;
+
+inline uint64_t HashBytes(const void *data, size_t size, uint64_t seed = kFnvOffset){
+    const uint8_t *p = static_cast<const uint8_t*>(data);
+    uint64_t h = seed;
+    for(size_t i = 0; i < size; ++i){
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "KeyCodes.h"
+
+// ---- Config code -> injection table ----
+// How each special mouse code is pressed and released. Anything not listed is a
+// keyboard VK. Profiles compile every macro's target through this once at load time.
+struct InjectTemplate {
+    int cfg;
+    InjectOp down;
+    InjectOp up;
+    uint8_t upCount;   // wheel notches have no release
+    bool keyboard;
+};
+
+static constexpr InjectTemplate kMouseTemplates[] = {
+    { kCfgMouseMiddle, { InjectOp::MOUSE, 0, kMouseMiddleDown, 0 },            { InjectOp::MOUSE, 0, kMouseMiddleUp, 0 },    1, false },
+    { kCfgMouseX1,     { InjectOp::MOUSE, 0, kMouseXDown, kXButton1 },         { InjectOp::MOUSE, 0, kMouseXUp, kXButton1 }, 1, false },
+    { kCfgMouseX2,     { InjectOp::MOUSE, 0, kMouseXDown, kXButton2 },         { InjectOp::MOUSE, 0, kMouseXUp, kXButton2 }, 1, false },
+    { kCfgRmb,         { InjectOp::MOUSE, 0, kMouseRightDown, 0 },             { InjectOp::MOUSE, 0, kMouseRightUp, 0 },     1, false },
+    { kCfgLmb,         { InjectOp::MOUSE, 0, kMouseLeftDown, 0 },              { InjectOp::MOUSE, 0, kMouseLeftUp, 0 },      1, false },
+    { kCfgWheelUp,     { InjectOp::MOUSE, 0, kMouseWheel, kWheelDelta },       { InjectOp::MOUSE, 0, 0, 0 },                 0, false },
+    { kCfgWheelDown,   { InjectOp::MOUSE, 0, kMouseWheel, -kWheelDelta },      { InjectOp::MOUSE, 0, 0, 0 },                 0, false },
+};
+
+constexpr InjectTemplate TemplateForConfigCode(int cfg){
+    for(const InjectTemplate &t : kMouseTemplates){
+        if(t.cfg == cfg) return t;
+    }
+    return InjectTemplate{ cfg, { InjectOp::KEY, (uint16_t)cfg, 0, 0 }, { InjectOp::KEY, (uint16_t)cfg, kKeyEventUp, 0 }, 1, true };
+}
+
+static_assert(TemplateForConfigCode(kCfgLmb).down.flags == kMouseLeftDown, "lmb template");
+static_assert(TemplateForConfigCode(kCfgWheelDown).upCount == 0, "wheel has no release");
+static_assert(TemplateForConfigCode('A').keyboard && TemplateForConfigCode('A').up.flags == kKeyEventUp, "keyboard template");
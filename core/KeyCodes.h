@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+
+// ---- Config codes ----
+// Codes used in profiles for the mouse actions that have no usable VK of their own.
+// Everything else in a profile is a plain Win32 virtual-key code.
+static const int kCfgMouseMiddle = 4;
+static const int kCfgMouseX1     = 5;
+static const int kCfgMouseX2     = 6;
+static const int kCfgRmb         = 252;
+static const int kCfgLmb         = 253;
+static const int kCfgWheelUp     = 254;
+static const int kCfgWheelDown   = 255;
+
+// ---- Virtual keys ----
+// Win32 VK values the engine refers to, spelled out so the core builds without <windows.h>
+static const int kVkLButton  = 0x01;
+static const int kVkRButton  = 0x02;
+static const int kVkMButton  = 0x04;
+static const int kVkXButton1 = 0x05;
+static const int kVkXButton2 = 0x06;
+static const int kVkBack     = 0x08;
+static const int kVkTab      = 0x09;
+static const int kVkReturn   = 0x0D;
+static const int kVkShift    = 0x10;
+static const int kVkControl  = 0x11;
+static const int kVkMenu     = 0x12;
+static const int kVkCapital  = 0x14;
+static const int kVkEscape   = 0x1B;
+static const int kVkSpace    = 0x20;
+static const int kVkF1       = 0x70;
+// Left/right modifiers, which is what the low-level hooks report
+static const int kVkLShift   = 0xA0;
+static const int kVkRShift   = 0xA1;
+static const int kVkLControl = 0xA2;
+static const int kVkRControl = 0xA3;
+static const int kVkLMenu    = 0xA4;
+static const int kVkRMenu    = 0xA5;
+
+// ---- Injection records ----
+// One injected input, field-for-field what a Win32 INPUT carries. Flag values are the
+// KEYEVENTF_* / MOUSEEVENTF_* constants so a backend can hand them to the OS unchanged.
+struct InjectOp {
+    enum Type : uint8_t { KEY = 0, MOUSE = 1 };
+    uint8_t  type;
+    uint16_t vk;
+    uint32_t flags;
+    int32_t  mouseData;
+};
+
+static const uint32_t kKeyEventUp       = 0x0002;
+static const uint32_t kMouseLeftDown    = 0x0002;
+static const uint32_t kMouseLeftUp      = 0x0004;
+static const uint32_t kMouseRightDown   = 0x0008;
+static const uint32_t kMouseRightUp     = 0x0010;
+static const uint32_t kMouseMiddleDown  = 0x0020;
+static const uint32_t kMouseMiddleUp    = 0x0040;
+static const uint32_t kMouseXDown       = 0x0080;
+static const uint32_t kMouseXUp         = 0x0100;
+static const uint32_t kMouseWheel       = 0x0800;
+static const int32_t  kXButton1         = 0x0001;
+static const int32_t  kXButton2         = 0x0002;
+static const int32_t  kWheelDelta       = 120;
+
+// ---- Captured input ----
+// A physical (non-injected) key or button transition as seen by an input source, or a
+// wheel movement: wheel is then the distance in kWheelDelta units, positive away from
+// the user, and vk is 0.
+struct InputEvent {
+    uint64_t timeNs;
+    uint8_t  vk;
+    bool     down;
+    int16_t  wheel = 0;
+};
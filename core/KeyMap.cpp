@@ -0,0 +1,224 @@
+#include "KeyMap.h"
+#include "KeyCodes.h"
+#include "Hash.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+std::string trim(const std::string &s){
+    size_t a=0, b=s.size();
+    while(a<b && std::isspace((unsigned char)s[a])) ++a;
+    while(b>a && std::isspace((unsigned char)s[b-1])) --b;
+    return s.substr(a,b-a);
+}
+std::string_view TrimView(std::string_view s){
+    size_t a=0, b=s.size();
+    while(a<b && std::isspace((unsigned char)s[a])) ++a;
+    while(b>a && std::isspace((unsigned char)s[b-1])) --b;
+    return s.substr(a,b-a);
+}
+std::string toLowerStr(std::string s){
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+// -------- KeyMapping.cfg loader --------
+bool KeyMap::Load(const std::string &path){
+    std::ifstream in(path);
+    if(!in.is_open()) return false;
+    std::string line;
+    size_t lineno = 0;
+    hash = kFnvOffset;
+    while(std::getline(in,line)){
+        ++lineno;
+        hash = HashBytes(line.data(), line.size(), hash);
+        hash = HashBytes("\n", 1, hash);
+        size_t pos = line.find_first_of("#;");
+        std::string s = (pos==std::string::npos) ? line : line.substr(0,pos);
+        s = trim(s);
+        if(s.empty()) continue;
+        size_t eq = s.find('=');
+        if(eq==std::string::npos) continue;
+        std::string name = trim(s.substr(0,eq));
+        std::string rhs  = trim(s.substr(eq+1));
+        if(name.empty() || rhs.empty()) continue;
+        size_t sp = rhs.find_first_of(" \t");
+        std::string valtok = (sp==std::string::npos) ? rhs : rhs.substr(0,sp);
+        try{
+            int code = std::stoi(valtok,nullptr,0);
+            names.Set(name, code);
+        }catch(...){
+            continue;
+        }
+    }
+    return true;
+}
+
+// -------- Flat name table --------
+void KeyNameTable::Grow(){
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.resize(old.empty() ? 64 : old.size() * 2);
+    size_t mask = slots.size() - 1;
+    for(auto &o : old){
+        if(!o.used) continue;
+        size_t i = o.hash & mask;
+        while(slots[i].used) i = (i + 1) & mask;
+        slots[i] = std::move(o);
+    }
+}
+
+void KeyNameTable::Set(std::string_view name, int code){
+    if((count + 1) * 2 > slots.size()) Grow();
+    uint32_t h = HashNameCI(name);
+    size_t mask = slots.size() - 1;
+    size_t i = h & mask;
+    while(slots[i].used){
+        if(slots[i].hash == h && EqualsCI(slots[i].name, name)){
+            slots[i].code = code;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    Slot &s = slots[i];
+    s.name = toLowerStr(std::string(name));
+    s.hash = h;
+    s.code = code;
+    s.used = true;
+    ++count;
+}
+
+int KeyNameTable::Find(std::string_view name) const {
+    if(slots.empty()) return -1;
+    uint32_t h = HashNameCI(name);
+    size_t mask = slots.size() - 1;
+    for(size_t i = h & mask; slots[i].used; i = (i + 1) & mask){
+        if(slots[i].hash == h && EqualsCI(slots[i].name, name)) return slots[i].code;
+    }
+    return -1;
+}
+
+// -------- Built-in names --------
+// Perfect hash: a seed is searched at compile time so the mixed HashNameCI puts
+// every built-in name in its own slot; a lookup is one hash, one compare.
+struct BuiltinName {
+    std::string_view name;
+    int code;
+};
+
+static constexpr BuiltinName kBuiltinNames[] = {
+    { "lmb", kCfgLmb },             { "mouse1", kCfgLmb },
+    { "rmb", kCfgRmb },             { "mouse2", kCfgRmb },
+    { "mmb", kCfgMouseMiddle },     { "mouse3", kCfgMouseMiddle },
+    { "mouse_middle", kCfgMouseMiddle },
+    { "mouse4", kCfgMouseX1 },      { "mouse5", kCfgMouseX2 },
+    { "mousewheel_up", kCfgWheelUp }, { "mousewheel_down", kCfgWheelDown },
+    { "space", kVkSpace },          { "shift", kVkShift },
+    { "ctrl", kVkControl },         { "alt", kVkMenu },
+    { "enter", kVkReturn },         { "return", kVkReturn },
+    { "esc", kVkEscape },           { "escape", kVkEscape },
+    { "tab", kVkTab },              { "backspace", kVkBack },
+    { "capslock", kVkCapital },
+};
+
+static constexpr size_t kBuiltinCount = sizeof(kBuiltinNames) / sizeof(kBuiltinNames[0]);
+static constexpr int kBuiltinBits = 6;
+static constexpr size_t kBuiltinSlots = size_t(1) << kBuiltinBits;
+
+constexpr size_t BuiltinSlot(std::string_view name, uint32_t seed){
+    uint32_t h = HashNameCI(name, seed) * 0x9E3779B1u;
+    return (h ^ (h >> 16)) & (kBuiltinSlots - 1);
+}
+
+constexpr uint32_t FindBuiltinSeed(){
+    for(uint32_t seed = 1; seed < 10000; ++seed){
+        bool taken[kBuiltinSlots] = {};
+        bool ok = true;
+        for(size_t i = 0; i < kBuiltinCount && ok; ++i){
+            size_t slot = BuiltinSlot(kBuiltinNames[i].name, seed);
+            if(taken[slot]) ok = false;
+            taken[slot] = true;
+        }
+        if(ok) return seed;
+    }
+    return 0;
+}
+
+static constexpr uint32_t kBuiltinSeed = FindBuiltinSeed();
+static_assert(kBuiltinSeed != 0, "no perfect-hash seed for the built-in key names");
+
+struct BuiltinSlots {
+    int8_t index[kBuiltinSlots];
+};
+
+constexpr BuiltinSlots BuildBuiltinSlots(){
+    BuiltinSlots t = {};
+    for(size_t i = 0; i < kBuiltinSlots; ++i) t.index[i] = -1;
+    for(size_t i = 0; i < kBuiltinCount; ++i) t.index[BuiltinSlot(kBuiltinNames[i].name, kBuiltinSeed)] = static_cast<int8_t>(i);
+    return t;
+}
+
+static constexpr BuiltinSlots kBuiltinSlotTable = BuildBuiltinSlots();
+
+int ResolveBuiltinKeyName(std::string_view name){
+    int i = kBuiltinSlotTable.index[BuiltinSlot(name, kBuiltinSeed)];
+    if(i < 0 || !EqualsCI(kBuiltinNames[i].name, name)) return -1;
+    return kBuiltinNames[i].code;
+}
+
+// Integer prefix parse with std::stoi's rules (leading space, sign, base 0 prefixes,
+// trailing junk ignored); false if there are no digits or the value overflows an int
+static bool ParseIntPrefix(std::string_view s, int base, int &out){
+    size_t i = 0, n = s.size();
+    while(i < n && std::isspace((unsigned char)s[i])) ++i;
+    bool neg = false;
+    if(i < n && (s[i] == '+' || s[i] == '-')){ neg = s[i] == '-'; ++i; }
+    if((base == 0 || base == 16) && i + 1 < n && s[i] == '0' && (s[i+1] == 'x' || s[i+1] == 'X')
+       && i + 2 < n && std::isxdigit((unsigned char)s[i+2])){
+        base = 16;
+        i += 2;
+    } else if(base == 0){
+        base = (i < n && s[i] == '0') ? 8 : 10;
+    }
+    int64_t v = 0;
+    size_t start = i;
+    for(; i < n; ++i){
+        char c = LowerAscii(s[i]);
+        int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'z') ? c - 'a' + 10 : 99;
+        if(d >= base) break;
+        v = v * base + d;
+        if(v > int64_t(INT32_MAX) + 1) return false;
+    }
+    if(i == start) return false;
+    if(neg) v = -v;
+    if(v > INT32_MAX || v < INT32_MIN) return false;
+    out = static_cast<int>(v);
+    return true;
+}
+
+// -------- Resolve name -> numeric code --------
+int KeyMap::Resolve(std::string_view name) const {
+    std::string_view n = TrimView(name);
+    if(n.empty()) return -1;
+    int code = names.Find(n);
+    if(code != -1) return code;
+
+    code = ResolveBuiltinKeyName(n);
+    if(code != -1) return code;
+
+    if(n.size()>=2 && LowerAscii(n[0])=='f'){
+        int fn;
+        if(ParseIntPrefix(n.substr(1), 10, fn) && fn >= 1 && fn <= 24) return kVkF1 + (fn-1);
+    }
+
+    if(n.size()==1){
+        char c = LowerAscii(n[0]);
+        if(c>='a' && c<='z') return (int)std::toupper(c);
+        if(c>='0' && c<='9') return (int)c;
+    }
+
+    if(ParseIntPrefix(n, 0, code)) return code;
+    return -1;
+}
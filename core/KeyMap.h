@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ---- Case-insensitive name hashing ----
+// FNV-1a over ASCII-lowercased bytes, usable at compile time for the built-in table.
+constexpr char LowerAscii(char c){
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr uint32_t HashNameCI(std::string_view s, uint32_t seed = 2166136261u){
+    uint32_t h = seed;
+    for(char c : s){
+        h ^= static_cast<uint8_t>(LowerAscii(c));
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr bool EqualsCI(std::string_view a, std::string_view b){
+    if(a.size() != b.size()) return false;
+    for(size_t i = 0; i < a.size(); ++i){
+        if(LowerAscii(a[i]) != LowerAscii(b[i])) return false;
+    }
+    return true;
+}
+
+// ---- Key name table ----
+// KeyMapping.cfg entries in a flat open-addressing table (linear probing, power-of-two
+// size, at most half full). Lookups hash the name case-insensitively in place, so
+// resolving a name never allocates.
+class KeyNameTable {
+public:
+    void Set(std::string_view name, int code);
+    // Returns the code for name, or -1 if it is not in the table
+    int Find(std::string_view name) const;
+    size_t Size() const { return count; }
+    void Clear(){ slots.clear(); count = 0; }
+
+private:
+    struct Slot {
+        std::string name;
+        uint32_t hash = 0;
+        int code = -1;
+        bool used = false;
+    };
+    void Grow();
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+};
+
+// ---- Key names ----
+// Names from KeyMapping.cfg plus the built-in fallbacks used when a name is not mapped.
+struct KeyMap {
+    KeyNameTable names;
+    // Hash of the loaded file's text, part of every compiled profile's cache key
+    uint64_t hash = 0;
+
+    bool Load(const std::string &path);
+    // Returns the config code for a key name, or -1 if it cannot be resolved
+    int Resolve(std::string_view name) const;
+};
+
+// Built-in names only (perfect-hashed at compile time); -1 if name is not one of them
+int ResolveBuiltinKeyName(std::string_view name);
+
+// -------- string utilities shared by the loaders --------
+std::string trim(const std::string &s);
+std::string toLowerStr(std::string s);
+std::string_view TrimView(std::string_view s);
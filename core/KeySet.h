@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+
+#include "KeyCodes.h"
+
+// ---- 256-bit key set ----
+// One bit per virtual key. Pressed-key state and chords are both key sets, so matching
+// a chord is four AND/compare pairs however many keys it has.
+struct KeySet {
+    uint64_t bits[4] = {};
+
+    bool Test(int vk) const { return ((bits[vk >> 6] >> (vk & 63)) & 1) != 0; }
+    void Set(int vk){ bits[vk >> 6] |= 1ull << (vk & 63); }
+    void Reset(int vk){ bits[vk >> 6] &= ~(1ull << (vk & 63)); }
+    void Assign(int vk, bool on){ if(on) Set(vk); else Reset(vk); }
+    void Clear(){ bits[0] = bits[1] = bits[2] = bits[3] = 0; }
+    bool Empty() const { return (bits[0] | bits[1] | bits[2] | bits[3]) == 0; }
+    int Count() const {
+        int n = 0;
+        for(uint64_t w : bits) for(; w; w &= w - 1) ++n;
+        return n;
+    }
+
+    // True if every key of other is also in this set
+    bool Contains(const KeySet &other) const {
+        return ((bits[0] & other.bits[0]) == other.bits[0]) & ((bits[1] & other.bits[1]) == other.bits[1])
+             & ((bits[2] & other.bits[2]) == other.bits[2]) & ((bits[3] & other.bits[3]) == other.bits[3]);
+    }
+    KeySet &operator|=(const KeySet &other){
+        for(int i = 0; i < 4; ++i) bits[i] |= other.bits[i];
+        return *this;
+    }
+    bool operator==(const KeySet &other) const {
+        return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2] && bits[3] == other.bits[3];
+    }
+};
+
+// ---- Pressed keys ----
+// The hooks report left and right modifiers separately; the generic shift/ctrl/alt
+// codes are kept as "either side held" so a chord may name either form.
+inline void UpdatePressed(KeySet &pressed, int vk, bool down){
+    pressed.Assign(vk, down);
+    if(vk >= kVkLShift && vk <= kVkRMenu){
+        int generic = kVkShift + (vk - kVkLShift) / 2;
+        int left = kVkLShift + (vk - kVkLShift) / 2 * 2;
+        pressed.Assign(generic, pressed.Test(left) || pressed.Test(left + 1));
+    }
+}
+
+// Keys whose events decide whether chord is held: its own keys, with a generic
+// modifier standing for both of its sides
+inline KeySet ChordEventKeys(const KeySet &chord){
+    KeySet keys = chord;
+    for(int generic = kVkShift; generic <= kVkMenu; ++generic){
+        if(!chord.Test(generic)) continue;
+        keys.Set(kVkLShift + (generic - kVkShift) * 2);
+        keys.Set(kVkLShift + (generic - kVkShift) * 2 + 1);
+    }
+    return keys;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// ---- Latency histogram ----
+// Log-linear buckets over nanoseconds: values below 16 are exact, above that each
+// power of two is split into 16 sub-buckets (~6% resolution), up to ~2^40 ns. Recording
+// is one relaxed atomic increment, so the hot path can record while another thread
+// reads percentiles.
+class LatencyHistogram {
+public:
+    static const int kSubBits = 4;
+    static const int kSub = 1 << kSubBits;
+    static const int kMaxBits = 40;
+    static const int kBuckets = (kMaxBits - kSubBits + 1) * kSub;
+
+    void Record(uint64_t ns){
+        counts[Index(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        uint64_t prev = maxNs.load(std::memory_order_relaxed);
+        while(ns > prev && !maxNs.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t Count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return maxNs.load(std::memory_order_relaxed); }
+
+    // Upper edge of the bucket holding the p-th quantile (0..1); 0 when empty
+    uint64_t Percentile(double p) const {
+        uint64_t n = 0;
+        for(int i = 0; i < kBuckets; ++i) n += counts[i].load(std::memory_order_relaxed);
+        if(n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(n - 1)) + 1;
+        uint64_t seen = 0;
+        for(int i = 0; i < kBuckets; ++i){
+            seen += counts[i].load(std::memory_order_relaxed);
+            if(seen >= rank){
+                uint64_t hi = UpperBound(i);
+                uint64_t mx = Max();
+                return hi < mx ? hi : mx;
+            }
+        }
+        return Max();
+    }
+
+    // Adds other's samples into this one (e.g. carrying stats across a reload)
+    void Merge(const LatencyHistogram &other){
+        for(int i = 0; i < kBuckets; ++i){
+            uint64_t c = other.counts[i].load(std::memory_order_relaxed);
+            if(c) counts[i].fetch_add(c, std::memory_order_relaxed);
+        }
+        total.fetch_add(other.Count(), std::memory_order_relaxed);
+        uint64_t ns = other.Max();
+        uint64_t prev = maxNs.load(std::memory_order_relaxed);
+        while(ns > prev && !maxNs.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+    }
+
+    void Reset(){
+        for(int i = 0; i < kBuckets; ++i) counts[i].store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+    }
+
+    static int Msb(uint64_t v){
+        int r = 0;
+        if(v >> 32){ v >>= 32; r += 32; }
+        if(v >> 16){ v >>= 16; r += 16; }
+        if(v >> 8) { v >>= 8;  r += 8; }
+        if(v >> 4) { v >>= 4;  r += 4; }
+        if(v >> 2) { v >>= 2;  r += 2; }
+        if(v >> 1) { r += 1; }
+        return r;
+    }
+    static int Index(uint64_t v){
+        if(v < static_cast<uint64_t>(kSub)) return static_cast<int>(v);
+        int msb = Msb(v);
+        if(msb >= kMaxBits) return kBuckets - 1;
+        int shift = msb - kSubBits;
+        return (shift + 1) * kSub + static_cast<int>((v >> shift) - kSub);
+    }
+    static uint64_t UpperBound(int idx){
+        if(idx < kSub) return static_cast<uint64_t>(idx);
+        int shift = idx / kSub - 1;
+        uint64_t sub = static_cast<uint64_t>(idx % kSub + kSub);
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> counts[kBuckets] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> maxNs{0};
+};
@@ -0,0 +1,560 @@
+#include "Profile.h"
+#include "KeyMap.h"
+#include "KeyCodes.h"
+#include "InjectTable.h"
+
+#include <fstream>
+#include <cmath>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+// ---- Map config code to VK code ----
+int MapConfigCodeToDetectVK(int cfg){
+    switch(cfg){
+        case kCfgLmb:         return kVkLButton;
+        case kCfgRmb:         return kVkRButton;
+        case kCfgMouseMiddle: return kVkMButton;
+        case kCfgMouseX1:     return kVkXButton1;
+        case kCfgMouseX2:     return kVkXButton2;
+        case kCfgWheelUp:     return -1;
+        case kCfgWheelDown:   return -1;
+        default: return cfg;
+    }
+}
+
+KeySet DefaultPauseChord(){
+    KeySet chord;
+    chord.Set('8');
+    chord.Set('9');
+    chord.Set('0');
+    return chord;
+}
+
+const char *ActionName(Macro::ActionType action){
+    switch(action){
+        case Macro::ACTION_AUTOCLICK: return "AutoClick";
+        case Macro::ACTION_BIND:      return "Bind";
+        case Macro::ACTION_SEQUENCE:  return "Sequence";
+        case Macro::ACTION_REPLAY:    return "Replay";
+    }
+    return "?";
+}
+
+int HeldChordSize(const Profile &profile, int vk, const KeySet &pressed){
+    int best = 0;
+    for(const DispatchEntry *e = profile.dispatch.First(vk), *end = profile.dispatch.Last(vk); e != end; ++e){
+        const KeySet &chord = profile.macros[e->macroIndex]->chord;
+        if(pressed.Contains(chord) && chord.Count() > best) best = chord.Count();
+    }
+    return best;
+}
+
+bool ShouldSuppressOriginal(const Macro* m){
+    if(m->keepOriginal) return false;
+    if(m->dropOriginal) return true;
+    return true;
+}
+
+// ---- Compile a macro's target into ready-to-send ops ----
+void CompileInjection(Macro &m){
+    InjectTemplate t = TemplateForConfigCode((int)m.targetCfg);
+    m.ops[0] = t.down;
+    m.ops[1] = t.up;
+    m.downCount = 1;
+    m.upCount = t.upCount;
+    m.keyboardTarget = t.keyboard;
+}
+
+// ---- Parse a macro line ----
+static bool Fail(ParseError *err, size_t column, const char *message){
+    if(err){
+        err->column = column + 1;
+        err->message = message;
+    }
+    return false;
+}
+
+// Reads a bracketed or quoted token starting at line[i] == open; i ends past the closer
+static bool ReadDelimited(std::string_view line, size_t &i, char close, std::string_view &out){
+    size_t start = ++i;
+    while(i < line.size() && line[i] != close) ++i;
+    if(i >= line.size()) return false;
+    out = TrimView(line.substr(start, i - start));
+    ++i;
+    return true;
+}
+
+static bool ApplyFlag(std::string_view tag, MacroTokens &out){
+    if(EqualsCI(tag, "k") || EqualsCI(tag, "keep")){
+        out.keep = true;
+        return true;
+    }
+    if(EqualsCI(tag, "d") || EqualsCI(tag, "drop")){
+        out.drop = true;
+        return true;
+    }
+    if(EqualsCI(tag, "coalesce")){
+        out.wheel = Macro::WHEEL_COALESCE;
+        return true;
+    }
+    if(EqualsCI(tag, "smooth")){
+        out.wheel = Macro::WHEEL_SMOOTH;
+        return true;
+    }
+    return false;
+}
+
+// std::stod semantics (partial parse, ERANGE rejected) without a std::string
+static bool ParseInterval(std::string_view s, double &out){
+    char buf[64];
+    if(s.empty() || s.size() >= sizeof(buf)) return false;
+    s.copy(buf, s.size());
+    buf[s.size()] = '\0';
+    char *end = nullptr;
+    errno = 0;
+    double v = std::strtod(buf, &end);
+    if(end == buf || errno == ERANGE) return false;
+    out = v;
+    return true;
+}
+
+bool ParseMacroLine(std::string_view line, MacroTokens &out, ParseError *err){
+    size_t i=0, n=line.size();
+    auto skip=[&](){ while(i<n && std::isspace((unsigned char)line[i])) ++i; };
+    out = MacroTokens();
+    skip();
+    if(!(i<n && line[i]=='[')) return Fail(err, i, "expected '[' before the action");
+    size_t open = i;
+    if(!ReadDelimited(line, i, ']', out.action)) return Fail(err, open, "unterminated '[' in the action");
+    skip();
+
+    bool isBind = EqualsCI(out.action, "bind");
+    if(!isBind && i<n && line[i]=='['){
+        open = i;
+        if(!ReadDelimited(line, i, ']', out.mode)) return Fail(err, open, "unterminated '[' in the mode");
+        skip();
+        // A sequence's mode is optional, so its first bracket may already be the flag
+        if(EqualsCI(out.action, "sequence") && ApplyFlag(out.mode, out)) out.mode = std::string_view();
+    }
+
+    // Flags may be combined, as in [D] [Coalesce]
+    while(i<n && line[i]=='['){
+        std::string_view tag;
+        open = i;
+        if(!ReadDelimited(line, i, ']', tag)) return Fail(err, open, "unterminated '[' in the flag");
+        if(!ApplyFlag(tag, out) && !out.unknownFlag.data()) out.unknownFlag = tag;
+        skip();
+    }
+
+    if(!(i<n && line[i]=='\"')) return Fail(err, i, "expected '\"' before the trigger");
+    open = i;
+    if(!ReadDelimited(line, i, '\"', out.trigger)) return Fail(err, open, "unterminated trigger name");
+    skip();
+    // [Pause] "chord", [App] "name", [Priority] "level", [Cores] "list" and [Budget] "rate" have no target
+    if(i>=n && (EqualsCI(out.action, "pause") || EqualsCI(out.action, "app") || EqualsCI(out.action, "priority")
+                || EqualsCI(out.action, "cores") || EqualsCI(out.action, "budget"))) return true;
+    if(!(i<n && line[i]=='\"')) return Fail(err, i, "expected '\"' before the target");
+    open = i;
+    if(!ReadDelimited(line, i, '\"', out.target)) return Fail(err, open, "unterminated target name");
+    skip();
+    if(i<n && line[i]=='['){
+        std::string_view istr;
+        open = i;
+        if(!ReadDelimited(line, i, ']', istr)) return Fail(err, open, "unterminated '[' in the interval");
+        double v;
+        if(!ParseInterval(istr, v) || std::isnan(v)) return Fail(err, open + 1, "interval is not a number");
+        if(v<=0) return Fail(err, open + 1, "interval must be positive");
+        if(v<kMinIntervalMs) return Fail(err, open + 1, "interval is below 0.001 ms");
+        if(v>kMaxIntervalMs) return Fail(err, open + 1, "interval is over a day");
+        out.interval = v;
+    }
+    return true;
+}
+
+// ---- Resolve a trigger ----
+// "key" or "mod+...+key": the last key is the trigger, the ones before it go into chord
+// as detect VKs. On failure column is the offset of the offending name within text.
+static bool ResolveChord(std::string_view text, const KeyMap &keys, int &trigger, KeySet &chord,
+                         size_t &column, const char *&message){
+    chord.Clear();
+    for(size_t i = 0; ; ){
+        size_t plus = text.find('+', i);
+        if(plus == std::string_view::npos) plus = text.size();
+        std::string_view name = TrimView(text.substr(i, plus - i));
+        column = name.empty() ? i : static_cast<size_t>(name.data() - text.data());
+        int code = keys.Resolve(name);
+        if(code == -1){
+            message = "unknown trigger key name";
+            return false;
+        }
+        if(plus == text.size()){
+            trigger = code;
+            return true;
+        }
+        int vk = MapConfigCodeToDetectVK(code);
+        if(vk <= 0 || vk >= DispatchTable::kSlots){
+            message = "key cannot be held in a chord";
+            return false;
+        }
+        chord.Set(vk);
+        i = plus + 1;
+    }
+}
+
+// ---- Compile a [Sequence] ----
+// Steps are comma-separated: "down <key>", "up <key>", "click <key>", "wait <ms>" and
+// "repeat <n>", which runs the steps since the previous repeat (or the start) n times
+// in total. Waits longer than a WAIT op can hold are split over several.
+static bool ParseRepeatCount(std::string_view s, uint32_t &out){
+    if(s.empty() || s.size() > 9) return false;
+    uint32_t v = 0;
+    for(char c : s){
+        if(c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<uint32_t>(c - '0');
+    }
+    out = v;
+    return true;
+}
+
+static bool CompileSequence(std::string_view steps, const KeyMap &keys, bool loops, std::vector<SeqOp> &out, ParseError *err){
+    const size_t first = out.size();
+    size_t blockStart = first;
+    bool waits = false;
+    for(size_t i = 0; ; ){
+        size_t comma = steps.find(',', i);
+        if(comma == std::string_view::npos) comma = steps.size();
+        std::string_view step = TrimView(steps.substr(i, comma - i));
+        size_t column = step.empty() ? i : static_cast<size_t>(step.data() - steps.data());
+        if(step.empty()) return Fail(err, column, "empty sequence step");
+        size_t space = step.find_first_of(" \t");
+        std::string_view verb = step.substr(0, space);
+        std::string_view operand = space == std::string_view::npos ? std::string_view() : TrimView(step.substr(space));
+        size_t operandColumn = operand.empty() ? column + step.size() : static_cast<size_t>(operand.data() - steps.data());
+
+        SeqOp op = {};
+        if(EqualsCI(verb, "down") || EqualsCI(verb, "up") || EqualsCI(verb, "click")){
+            int key = keys.Resolve(operand);
+            if(key == -1) return Fail(err, operandColumn, "unknown key name in sequence");
+            if(key < 0 || key > 0xFF) return Fail(err, operandColumn, "key code out of range in sequence");
+            op.code = EqualsCI(verb, "down") ? SeqOp::DOWN : EqualsCI(verb, "up") ? SeqOp::UP : SeqOp::CLICK;
+            op.key = static_cast<uint16_t>(key);
+            out.push_back(op);
+        } else if(EqualsCI(verb, "wait")){
+            double ms;
+            if(!ParseInterval(operand, ms) || std::isnan(ms)) return Fail(err, operandColumn, "wait is not a number");
+            if(ms > kMaxWaitMs) return Fail(err, operandColumn, "wait is over a day");
+            if(ms < kMinIntervalMs) return Fail(err, operandColumn, "wait is below 0.001 ms");
+            uint64_t ns = static_cast<uint64_t>(std::llround(ms * 1000000.0));
+            // Checked before anything is pushed, so a long wait cannot grow the program first
+            size_t splits = static_cast<size_t>((ns + 0xFFFFFFFEull) / 0xFFFFFFFFull);
+            if(out.size() - first + splits > kMaxSequenceOps) return Fail(err, column, "sequence is too long");
+            op.code = SeqOp::WAIT;
+            for(; ns > 0xFFFFFFFFull; ns -= 0xFFFFFFFFull){
+                op.arg = 0xFFFFFFFFu;
+                out.push_back(op);
+            }
+            op.arg = static_cast<uint32_t>(ns);
+            out.push_back(op);
+            waits = true;
+        } else if(EqualsCI(verb, "repeat")){
+            uint32_t count;
+            if(!ParseRepeatCount(operand, count) || count < 1 || count > kMaxRepeatCount){
+                return Fail(err, operandColumn, "repeat count must be 1 to 10000");
+            }
+            if(out.size() == blockStart) return Fail(err, column, "repeat has no steps before it");
+            op.code = SeqOp::REPEAT;
+            op.key = static_cast<uint16_t>(blockStart - first);
+            op.arg = count;
+            out.push_back(op);
+            blockStart = out.size();
+        } else {
+            return Fail(err, column, "unknown sequence step");
+        }
+        if(out.size() - first > kMaxSequenceOps) return Fail(err, column, "sequence is too long");
+        if(comma == steps.size()) break;
+        i = comma + 1;
+    }
+    // A program that loops while its trigger is active has to give the clock a turn
+    if(loops && !waits) return Fail(err, 0, "a looping sequence needs a wait");
+    return true;
+}
+
+// ---- Thread settings ----
+static bool ParsePriority(std::string_view s, ThreadPolicy::Priority &out){
+    s = TrimView(s);
+    if(EqualsCI(s, "normal")) out = ThreadPolicy::NORMAL;
+    else if(EqualsCI(s, "high")) out = ThreadPolicy::HIGH;
+    else if(EqualsCI(s, "realtime")) out = ThreadPolicy::REALTIME;
+    else return false;
+    return true;
+}
+
+// "2", "2,3" or "0,4-7" as a mask; on failure column is the offset of the bad item
+static bool ParseCores(std::string_view s, uint64_t &mask, size_t &column){
+    mask = 0;
+    for(size_t i = 0; ; ){
+        size_t comma = s.find(',', i);
+        if(comma == std::string_view::npos) comma = s.size();
+        std::string_view item = TrimView(s.substr(i, comma - i));
+        column = item.empty() ? i : static_cast<size_t>(item.data() - s.data());
+        size_t dash = item.find('-');
+        uint32_t first, last;
+        if(!ParseRepeatCount(TrimView(item.substr(0, dash)), first)) return false;
+        last = first;
+        if(dash != std::string_view::npos && !ParseRepeatCount(TrimView(item.substr(dash + 1)), last)) return false;
+        if(last < first || last > 63) return false;
+        for(uint32_t c = first; c <= last; ++c) mask |= uint64_t(1) << c;
+        if(comma == s.size()) return true;
+        i = comma + 1;
+    }
+}
+
+// ---- Parse macros ----
+size_t ParseMacros(std::string_view text, const KeyMap &keys, Profile &out, std::vector<ParseError> *errors){
+    size_t lineno=0;
+    size_t skipped=0;
+    ParseError err = { 0, 0, std::string() };
+    ParseError *errp = errors ? &err : nullptr;
+    auto reject = [&](size_t column, const char *message){
+        ++skipped;
+        if(errors) errors->push_back(ParseError{ lineno, column + 1, message });
+    };
+
+    for(size_t pos = 0; pos < text.size();){
+        size_t eol = text.find('\n', pos);
+        if(eol == std::string_view::npos) eol = text.size();
+        std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        ++lineno;
+
+        size_t cpos = line.find_first_of("#;");
+        if(cpos != std::string_view::npos) line = line.substr(0, cpos);
+        std::string_view s = TrimView(line);
+        if(s.empty()) continue;
+        // Columns are reported against the raw line, not the trimmed one
+        size_t indent = static_cast<size_t>(s.data() - line.data());
+
+        MacroTokens t;
+        if(!ParseMacroLine(s, t, errp)){
+            ++skipped;
+            if(errors) errors->push_back(ParseError{ lineno, indent + err.column, err.message });
+            continue;
+        }
+
+        if(EqualsCI(t.action, "app")){
+            AppMatch app;
+            app.kind = EqualsCI(t.mode, "class") ? AppMatch::WINDOW_CLASS : AppMatch::EXE;
+            if(!t.mode.empty() && !EqualsCI(t.mode, "class") && !EqualsCI(t.mode, "exe")){
+                reject(indent + static_cast<size_t>(t.mode.data() - s.data()), "unknown [App] kind, use [Exe] or [Class]");
+            } else if(t.target.data()){
+                reject(indent + static_cast<size_t>(t.target.data() - s.data()), "[App] takes only a name");
+            } else if(t.trigger.empty()){
+                reject(indent + static_cast<size_t>(t.trigger.data() - s.data()), "empty application name");
+            } else {
+                app.name = toLowerStr(std::string(t.trigger));
+                out.apps.push_back(app);
+            }
+            continue;
+        }
+
+        bool priority = EqualsCI(t.action, "priority");
+        if(priority || EqualsCI(t.action, "cores")){
+            // Without a thread named, the setting is for both
+            bool inject = t.mode.empty() || EqualsCI(t.mode, "inject");
+            bool capture = t.mode.empty() || EqualsCI(t.mode, "capture");
+            size_t valueColumn = indent + static_cast<size_t>(t.trigger.data() - s.data());
+            ThreadPolicy::Priority level = ThreadPolicy::NORMAL;
+            uint64_t cores = 0;
+            size_t badColumn = 0;
+            if(!inject && !capture){
+                reject(indent + static_cast<size_t>(t.mode.data() - s.data()), "unknown thread, use [Inject] or [Capture]");
+            } else if(t.target.data()){
+                reject(indent + static_cast<size_t>(t.target.data() - s.data()),
+                       priority ? "[Priority] takes only a level" : "[Cores] takes only a list of cores");
+            } else if(priority && !ParsePriority(t.trigger, level)){
+                reject(valueColumn, "unknown priority, use normal, high or realtime");
+            } else if(!priority && !ParseCores(t.trigger, cores, badColumn)){
+                reject(valueColumn + badColumn, "expected cores 0 to 63 such as \"2\", \"2,3\" or \"4-7\"");
+            } else {
+                for(ThreadPolicy *policy : { inject ? &out.injectPolicy : nullptr, capture ? &out.capturePolicy : nullptr }){
+                    if(!policy) continue;
+                    if(priority) policy->priority = level;
+                    else policy->cores = cores;
+                }
+            }
+            continue;
+        }
+
+        if(EqualsCI(t.action, "budget")){
+            uint32_t rate = 0;
+            if(!t.mode.empty()){
+                reject(indent + static_cast<size_t>(t.mode.data() - s.data()), "[Budget] takes no mode");
+            } else if(t.target.data()){
+                reject(indent + static_cast<size_t>(t.target.data() - s.data()), "[Budget] takes only a rate");
+            } else if(!ParseRepeatCount(TrimView(t.trigger), rate) || rate > kMaxInjectBudget){
+                reject(indent + static_cast<size_t>(t.trigger.data() - s.data()),
+                       "expected events per second from 1 to 1000000, or 0 for no limit");
+            } else {
+                out.injectBudget = rate;
+            }
+            continue;
+        }
+
+        int trg;
+        KeySet chord;
+        size_t chordColumn;
+        const char *chordError;
+        size_t triggerColumn = indent + static_cast<size_t>(t.trigger.data() - s.data());
+        if(!ResolveChord(t.trigger, keys, trg, chord, chordColumn, chordError)){
+            reject(triggerColumn + chordColumn, chordError);
+            continue;
+        }
+        if(EqualsCI(t.action, "pause")){
+            int vk = MapConfigCodeToDetectVK(trg);
+            if(t.target.data()){
+                reject(indent + static_cast<size_t>(t.target.data() - s.data()), "[Pause] takes only a chord");
+            } else if(vk <= 0 || vk >= DispatchTable::kSlots){
+                reject(triggerColumn + chordColumn, "key cannot be held in a chord");
+            } else {
+                chord.Set(vk);
+                out.pauseChord = chord;
+            }
+            continue;
+        }
+        bool sequence = EqualsCI(t.action, "sequence");
+        bool replay = EqualsCI(t.action, "replay");
+        // A sequence's target field holds its steps, compiled below; a replay's, its trace file
+        int tgt = sequence || replay ? 0 : keys.Resolve(t.target);
+        if(tgt == -1){
+            reject(indent + static_cast<size_t>(t.target.data() - s.data()), "unknown target key name");
+            continue;
+        }
+        bool autoclick = EqualsCI(t.action, "autoclick");
+        if(!autoclick && !sequence && !replay && !EqualsCI(t.action, "bind")){
+            reject(indent + static_cast<size_t>(t.action.data() - s.data()), "unknown action");
+            continue;
+        }
+        if(autoclick && t.interval==0){
+            reject(indent + s.size(), "autoclick needs an interval");
+            continue;
+        }
+        if(t.wheel != Macro::WHEEL_EACH && (!autoclick || (tgt != kCfgWheelUp && tgt != kCfgWheelDown))){
+            reject(indent + static_cast<size_t>(t.target.data() - s.data()),
+                   "[Coalesce] and [Smooth] need an autoclick on mousewheel_up or mousewheel_down");
+            continue;
+        }
+        if(out.macros.size() >= kMaxMacros){
+            reject(indent, "too many macros");
+            continue;
+        }
+        size_t sequenceBegin = out.sequenceOps.size();
+        bool once = false;
+        if(replay){
+            if(t.interval != 0){
+                size_t at = s.find('[', static_cast<size_t>(t.target.data() - s.data()) + t.target.size());
+                reject(indent + at, "a replay has no interval, it follows the trace");
+                continue;
+            }
+            once = t.mode.empty() || EqualsCI(t.mode, "once");
+            if(!once && !EqualsCI(t.mode, "hold") && !EqualsCI(t.mode, "toggle")){
+                reject(indent + static_cast<size_t>(t.mode.data() - s.data()), "unknown replay mode");
+                continue;
+            }
+            if(t.target.empty()){
+                reject(indent + static_cast<size_t>(t.target.data() - s.data()), "empty trace file name");
+                continue;
+            }
+        }
+        if(sequence){
+            size_t targetColumn = indent + static_cast<size_t>(t.target.data() - s.data());
+            if(t.interval != 0){
+                size_t at = s.find('[', static_cast<size_t>(t.target.data() - s.data()) + t.target.size());
+                reject(indent + at, "a sequence has no interval, use wait steps");
+                continue;
+            }
+            once = t.mode.empty() || EqualsCI(t.mode, "once");
+            if(!once && !EqualsCI(t.mode, "hold") && !EqualsCI(t.mode, "toggle")){
+                reject(indent + static_cast<size_t>(t.mode.data() - s.data()), "unknown sequence mode");
+                continue;
+            }
+            if(!CompileSequence(t.target, keys, !once, out.sequenceOps, errp)){
+                out.sequenceOps.resize(sequenceBegin);
+                ++skipped;
+                if(errors) errors->push_back(ParseError{ lineno, targetColumn + err.column, err.message });
+                continue;
+            }
+        }
+
+        // Unknown flags were always skipped over; the macro stays, with a warning
+        if(errors && t.unknownFlag.data()){
+            errors->push_back(ParseError{ lineno, indent + static_cast<size_t>(t.unknownFlag.data() - s.data()) + 1,
+                                          "unknown flag, ignored", true });
+        }
+        Macro *m = out.NewMacro();
+        m->definition.assign(s.data(), s.size());
+        m->triggerCfg = static_cast<uint32_t>(trg);
+        m->targetCfg  = static_cast<uint32_t>(tgt);
+        m->chord = chord;
+        m->clickHold = true;
+        m->keepOriginal = t.keep;
+        m->dropOriginal = t.drop;
+        m->bindKeepOriginal = t.keep;
+        m->bindDropOriginal = t.drop;
+        if(autoclick){
+            m->action = Macro::ACTION_AUTOCLICK;
+            if(EqualsCI(t.mode, "toggle")) m->clickHold = false;
+            m->originalIntervalMs = static_cast<float>(t.interval);
+            m->periodNs = static_cast<uint64_t>(std::llround(t.interval * 1000000.0));
+            m->wheelMode = static_cast<Macro::WheelMode>(t.wheel);
+        } else if(sequence){
+            m->action = Macro::ACTION_SEQUENCE;
+            m->clickHold = !EqualsCI(t.mode, "toggle");
+            m->runOnce = once;
+            m->sequenceBegin = static_cast<uint32_t>(sequenceBegin);
+            m->sequenceLength = static_cast<uint32_t>(out.sequenceOps.size() - sequenceBegin);
+        } else if(replay){
+            m->action = Macro::ACTION_REPLAY;
+            m->clickHold = !EqualsCI(t.mode, "toggle");
+            m->runOnce = once;
+            m->traceFile.assign(t.target.data(), t.target.size());
+        } else {
+            m->action = Macro::ACTION_BIND;
+            m->originalIntervalMs = 0.0f;
+        }
+        CompileInjection(*m);
+    }
+
+    std::vector<int> detect(out.macros.size());
+    for(size_t i = 0; i < out.macros.size(); ++i) detect[i] = MapConfigCodeToDetectVK((int)out.macros[i]->triggerCfg);
+    out.dispatch.Build(detect.data(), detect.size());
+    for(int vk = 0; vk < DispatchTable::kSlots; ++vk){
+        if(out.dispatch.Empty(vk)) continue;
+        bool anySuppress = false, anyChord = false;
+        for(const DispatchEntry *e = out.dispatch.First(vk), *end = out.dispatch.Last(vk); e != end; ++e){
+            const Macro *m = out.macros[e->macroIndex];
+            anySuppress |= ShouldSuppressOriginal(m);
+            anyChord |= !m->chord.Empty();
+        }
+        if(anySuppress) out.suppress[vk] = anyChord ? kSuppressChord : kSuppressAlways;
+    }
+    for(auto m : out.macros) out.chordKeys |= ChordEventKeys(m->chord);
+    return skipped;
+}
+
+size_t ParseMacros(std::istream &in, const KeyMap &keys, Profile &out, std::vector<ParseError> *errors){
+    std::ostringstream text;
+    text << in.rdbuf();
+    return ParseMacros(std::string_view(text.str()), keys, out, errors);
+}
+
+// ---- Load macros file ----
+bool LoadMacrosFile(const std::string &path, const KeyMap &keys, Profile &out, std::vector<ParseError> *errors){
+    std::ifstream in(path, std::ios::binary);
+    if(!in.is_open()){
+        return false;
+    }
+    ParseMacros(in, keys, out, errors);
+    return true;
+}
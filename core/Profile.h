@@ -0,0 +1,244 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <istream>
+#include <atomic>
+#include <memory>
+
+#include "Arena.h"
+#include "Backend.h"
+#include "DispatchTable.h"
+#include "KeyCodes.h"
+#include "KeySet.h"
+#include "Stats.h"
+#include "TokenBucket.h"
+#include "Trace.h"
+
+struct KeyMap;
+
+// ---- Sequence bytecode ----
+// A [Sequence] macro's steps, compiled at load time. The engine runs a program from its
+// pc up to the next WAIT in one pass, so a step is a switch case: no allocation, no
+// sleeping thread, and any number of sequences share the deadline heap.
+struct SeqOp {
+    enum Code : uint8_t { DOWN = 0, UP = 1, CLICK = 2, WAIT = 3, REPEAT = 4 };
+    uint8_t  code;
+    uint8_t  reserved;
+    // DOWN/UP/CLICK: config code of the key; REPEAT: index of the block's first step
+    uint16_t key;
+    // WAIT: nanoseconds; REPEAT: how many times the block runs in total
+    uint32_t arg;
+};
+
+// Macros in one profile; dispatch entries and the compiled image index them in 16 bits
+static const size_t kMaxMacros = DispatchTable::kMaxEntries;
+static const size_t kMaxSequenceOps = 0xFFFF;
+static const uint32_t kMaxRepeatCount = 10000;
+// Longest single wait step, one day; it is split over WAIT ops of up to 2^32-1 ns each
+static const double kMaxWaitMs = 86400000.0;
+static const uint32_t kMaxInjectBudget = 1000000;
+
+// Laid out in three parts so that no cache line mixes data written at run time with
+// data only read: the load-time config the hook reads, the flags the worker flips,
+// and the worker's scheduling state and stats. Each part starts on its own line, and
+// as the size is then a multiple of the line, neighbouring macros in the profile's
+// arena never share one either.
+struct alignas(64) Macro {
+    // ---- Config: set at load, read-only once the profile is published ----
+    // Normalized source line; reloads match macros by it to carry state across edits
+    std::string definition;
+    enum ActionType { ACTION_AUTOCLICK = 0, ACTION_BIND = 1, ACTION_SEQUENCE = 2, ACTION_REPLAY = 3 } action = ACTION_AUTOCLICK;
+    bool clickHold = true;
+    // [Sequence]/[Replay]: one run per trigger press instead of looping while active
+    bool runOnce = false;
+    bool bindKeepOriginal = false;
+    bool bindDropOriginal = false;
+    bool keepOriginal = false;
+    bool dropOriginal = false;
+    uint32_t triggerCfg = 0;
+    uint32_t targetCfg = 0;
+    // Chord trigger ("ctrl+mouse4"): keys that must already be held when the trigger
+    // key is pressed, as detect VKs. Empty for a plain single-key trigger.
+    KeySet chord;
+    float originalIntervalMs = 0.0f;
+    // Injection compiled at load time: ops[0..downCount) presses the target,
+    // ops[1..1+upCount) releases it, ops[0..downCount+upCount) is one click
+    InjectOp ops[2] = {};
+    uint8_t downCount = 0;
+    uint8_t upCount = 0;
+    bool keyboardTarget = false;
+    // [Sequence] program: Profile::sequenceOps[sequenceBegin, sequenceBegin + sequenceLength)
+    uint32_t sequenceBegin = 0;
+    uint32_t sequenceLength = 0;
+    // [Replay]: trace file as written in the profile, and its events once AttachTraces
+    // found it (null until then, or if it could not be read)
+    std::string traceFile;
+    const TraceData *trace = nullptr;
+    // Click period, the configured interval to the nanosecond. One click is owed per
+    // period on an absolute timeline starting at activation, however fast the interval.
+    uint64_t periodNs = 0;
+    // Autoclicked wheel: one event per notch, or [Coalesce] the notches owed at a fire
+    // into one event of n * kWheelDelta, or [Smooth] the exact distance scrolled since
+    // the last fire, in fractions of a notch
+    enum WheelMode : uint8_t { WHEEL_EACH = 0, WHEEL_COALESCE = 1, WHEEL_SMOOTH = 2 } wheelMode = WHEEL_EACH;
+
+    // ---- Flags: flipped by the worker, read from the control thread ----
+    alignas(64) std::atomic_bool active{false};
+    std::atomic_bool bindTargetDown{false};
+
+    // ---- Scheduler state, owned by the engine's scheduler thread ----
+    alignas(64) uint64_t nextDueNs = 0;
+    bool scheduled = false;
+    // Running sequence: next step, runs of the current repeat block, keys it holds down.
+    // A running replay uses the pc as its next event and holds keys the same way.
+    uint32_t sequencePc = 0;
+    uint32_t sequenceLoop = 0;
+    KeySet sequenceHeld;
+    // Running replay: when the current pass started, the origin of its event times
+    uint64_t replayOriginNs = 0;
+    // Running autoclicker: its share of the profile's [Budget], unlimited when it has none
+    TokenBucket share;
+    // Running autoclicker: time between fires, the period unless the wheel coalesces.
+    // A coalescing wheel also keeps the distance scrolled, in 1/kWheelDelta notches, and
+    // the remainder of it not sent yet, in units of 1/(kWheelDelta * periodNs) notch.
+    uint64_t firePeriodNs = 0;
+    uint64_t wheelUnits = 0;
+    uint64_t wheelCarry = 0;
+    MacroStats stats;
+};
+
+enum : uint8_t { kSuppressNever = 0, kSuppressAlways = 1, kSuppressChord = 2 };
+
+KeySet DefaultPauseChord();
+
+// ---- Application match ----
+// [App] "game.exe" or [App] [Class] "UnrealWindow": a foreground application the profile
+// is for, by executable file name or top-level window class. Stored lowercased.
+struct AppMatch {
+    enum Kind : uint8_t { EXE = 0, WINDOW_CLASS = 1 };
+    Kind kind;
+    std::string name;
+};
+
+// ---- Loaded profile ----
+// All macros of one .ini plus the tables built from them. The macros live in the
+// profile's arena and are freed with it in one go.
+struct Profile {
+    // In file order; create them with NewMacro
+    std::vector<Macro*> macros;
+    Arena<Macro> macroArena;
+    // Programs of every [Sequence] macro, back to back
+    std::vector<SeqOp> sequenceOps;
+    DispatchTable dispatch;
+    // Per VK: whether a press swallows the original event. kSuppressChord means the key
+    // has chord macros, so the answer depends on which chord, if any, the keys held complete.
+    uint8_t suppress[DispatchTable::kSlots] = {};
+    // Every key whose events a chord on this profile depends on
+    KeySet chordKeys;
+    // Pressing every key of it pauses or resumes the engine; 8+9+0 unless set by [Pause]
+    KeySet pauseChord = DefaultPauseChord();
+    // Applications that switch to this profile when they take the foreground
+    std::vector<AppMatch> apps;
+    // How the engine's worker (injection) and the input source's thread (capture) are
+    // scheduled while this profile is active; [Priority] and [Cores]
+    ThreadPolicy injectPolicy;
+    ThreadPolicy capturePolicy;
+    // [Budget]: events per second the engine may inject while this profile is active,
+    // shared fairly among the running autoclickers; 0 for no limit
+    uint32_t injectBudget = 0;
+    // Traces the [Replay] macros play, loaded by AttachTraces
+    std::vector<std::unique_ptr<TraceData>> traces;
+
+    Profile() = default;
+    Profile(const Profile&) = delete;
+    Profile& operator=(const Profile&) = delete;
+
+    Macro *NewMacro(){
+        Macro *m = macroArena.New();
+        macros.push_back(m);
+        return m;
+    }
+    void ClearMacros(){
+        macros.clear();
+        macroArena.Clear();
+    }
+};
+
+int MapConfigCodeToDetectVK(int cfg);
+// Action as spelled in profiles: "AutoClick", "Bind", "Sequence" or "Replay"
+const char *ActionName(Macro::ActionType action);
+bool ShouldSuppressOriginal(const Macro *m);
+// Key count of the largest chord held among the macros on vk (0 for a plain trigger).
+// Only the macros with a held chord of that size fire, so "ctrl+e" shadows "e" and
+// "ctrl+shift+e" shadows both.
+int HeldChordSize(const Profile &profile, int vk, const KeySet &pressed);
+void CompileInjection(Macro &m);
+
+// ---- Profile parsing ----
+// A rejected line, positioned at the token that broke it (1-based line and column). A
+// warning marks a line that was kept with only that token ignored.
+struct ParseError {
+    size_t line;
+    size_t column;
+    std::string message;
+    bool warning = false;
+};
+
+// Shortest autoclick interval accepted, one click per microsecond
+static const double kMinIntervalMs = 0.001;
+// Longest autoclick interval accepted, one click a day
+static const double kMaxIntervalMs = 86400000.0;
+
+// Tokens of one macro line; views into the line passed to ParseMacroLine
+struct MacroTokens {
+    std::string_view action;
+    std::string_view mode;
+    std::string_view trigger;
+    std::string_view target;
+    bool keep = false;
+    bool drop = false;
+    // [Coalesce] or [Smooth], in the flag's place
+    uint8_t wheel = Macro::WHEEL_EACH;
+    // First flag bracket that is none of the known ones; it is ignored
+    std::string_view unknownFlag;
+    double interval = 0.0;
+};
+
+// Tokenizes one comment-free macro line without allocating. On failure returns false
+// and, if err is given, sets err->column (relative to line) and err->message.
+bool ParseMacroLine(std::string_view line, MacroTokens &out, ParseError *err = nullptr);
+
+// Parses every macro line of a profile in one pass over the text. Rejected lines are
+// skipped, counted in the return value and reported to errors if given, as are unknown
+// flags on kept lines, as warnings that are not counted; apart from
+// the macros themselves (and any errors) nothing is allocated.
+size_t ParseMacros(std::string_view text, const KeyMap &keys, Profile &out, std::vector<ParseError> *errors = nullptr);
+size_t ParseMacros(std::istream &in, const KeyMap &keys, Profile &out, std::vector<ParseError> *errors = nullptr);
+bool LoadMacrosFile(const std::string &path, const KeyMap &keys, Profile &out, std::vector<ParseError> *errors = nullptr);
+
+// ---- Replay traces ----
+// Maps the trace of every [Replay] macro, relative to dir unless the profile gave an
+// absolute path. A trace that is missing or malformed leaves its macro inert and its
+// file name is added to failed. MappedFile as for LoadProfileCached. Attach before
+// the profile is published; returns how many traces were mapped.
+template <typename MappedFile>
+size_t AttachTraces(Profile &profile, const std::string &dir, std::vector<std::string> *failed = nullptr){
+    size_t attached = 0;
+    for(auto m : profile.macros){
+        if(m->action != Macro::ACTION_REPLAY || m->trace) continue;
+        const std::string &file = m->traceFile;
+        bool absolute = (!file.empty() && (file[0] == '/' || file[0] == '\\')) || file.find(':') != std::string::npos;
+        std::string path = absolute || dir.empty() ? file : dir + (dir.back() == '/' || dir.back() == '\\' ? "" : "/") + file;
+        std::unique_ptr<MappedTrace<MappedFile>> trace(new MappedTrace<MappedFile>());
+        if(!trace->Open(path)){
+            if(failed) failed->push_back(file);
+            continue;
+        }
+        m->trace = trace.get();
+        profile.traces.push_back(std::move(trace));
+        ++attached;
+    }
+    return attached;
+}
@@ -0,0 +1,374 @@
+#include "ProfileCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+
+struct CacheHeader {
+    char     magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t macroCount;
+    uint32_t entryCount;
+    uint32_t stringBytes;
+    uint32_t sequenceOpCount;
+    uint64_t pauseChord[4];
+    uint32_t appCount;
+    // [Priority] and [Cores] of the worker and input threads
+    uint8_t  injectPriority;
+    uint8_t  capturePriority;
+    uint8_t  reserved[2];
+    uint64_t injectCores;
+    uint64_t captureCores;
+    // [Budget], events per second
+    uint32_t injectBudget;
+    uint32_t errorCount;
+    // ProfileSourceStamp of the .ini when the image was written, 0 if it was not taken
+    uint64_t sourceStamp;
+};
+
+struct CacheMacro {
+    uint32_t triggerCfg;
+    uint32_t targetCfg;
+    float    originalIntervalMs;
+    uint32_t sequenceBegin;
+    uint64_t periodNs;
+    uint64_t chord[4];
+    InjectOp ops[2];
+    uint32_t definitionOffset;
+    uint32_t definitionLength;
+    uint32_t sequenceLength;
+    uint8_t  action;
+    uint8_t  flags;
+    uint8_t  downCount;
+    uint8_t  upCount;
+    // [Replay] trace file name, stored right after the definition
+    uint32_t traceFileLength;
+    uint8_t  wheelMode;
+    uint8_t  reserved[3];
+};
+
+struct CacheApp {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint8_t  kind;
+    uint8_t  reserved[3];
+};
+
+// A line the parser rejected, so a hit reports the same errors as a rebuild
+struct CacheError {
+    uint32_t line;
+    uint32_t column;
+    uint32_t messageOffset;
+    uint32_t messageLength;
+    uint8_t  warning;
+    uint8_t  reserved[3];
+};
+
+enum : uint8_t {
+    kFlagClickHold        = 1 << 0,
+    kFlagKeepOriginal     = 1 << 1,
+    kFlagDropOriginal     = 1 << 2,
+    kFlagBindKeepOriginal = 1 << 3,
+    kFlagBindDropOriginal = 1 << 4,
+    kFlagKeyboardTarget   = 1 << 5,
+    kFlagRunOnce          = 1 << 6,
+};
+
+static const char kCacheMagic[4] = { 'U', 'M', 'P', 'C' };
+static const size_t kBeginBytes = sizeof(uint16_t) * (DispatchTable::kSlots + 1);
+
+static_assert(std::is_trivially_copyable<CacheMacro>::value && std::is_trivially_copyable<DispatchEntry>::value
+              && std::is_trivially_copyable<SeqOp>::value && std::is_trivially_copyable<CacheApp>::value
+              && std::is_trivially_copyable<CacheError>::value,
+              "cache records are copied byte for byte");
+static_assert(sizeof(CacheHeader) % 8 == 0 && sizeof(CacheMacro) % 8 == 0 && sizeof(SeqOp) == 8,
+              "cache records must keep 8-byte alignment");
+
+// Offsets of each section; every one stays aligned for its element type
+struct CacheLayout {
+    size_t macros, sequence, begin, entries, suppress, apps, errors, strings, total;
+
+    CacheLayout(uint32_t macroCount, uint32_t sequenceOpCount, uint32_t entryCount, uint32_t appCount,
+                uint32_t errorCount, uint32_t stringBytes){
+        macros   = sizeof(CacheHeader);
+        sequence = macros + sizeof(CacheMacro) * macroCount;
+        begin    = sequence + sizeof(SeqOp) * sequenceOpCount;
+        entries  = begin + ((kBeginBytes + 3) & ~size_t(3));
+        suppress = entries + sizeof(DispatchEntry) * entryCount;
+        apps     = suppress + DispatchTable::kSlots;
+        errors   = apps + sizeof(CacheApp) * appCount;
+        strings  = errors + sizeof(CacheError) * errorCount;
+        total    = strings + stringBytes;
+    }
+};
+
+// ---- Hashing ----
+uint64_t ProfileSourceHash(std::string_view iniText, const KeyMap &keys){
+    uint64_t h = HashBytes(&kProfileCacheVersion, sizeof(kProfileCacheVersion));
+    h = HashBytes(&keys.hash, sizeof(keys.hash), h);
+    return HashBytes(iniText.data(), iniText.size(), h);
+}
+
+// Two seconds covers the coarsest timestamps of the file systems a profile lives on
+static const std::chrono::seconds kStampSettle(2);
+
+uint64_t ProfileSourceStamp(const std::string &iniPath, const KeyMap &keys){
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(iniPath, ec);
+    if(ec) return 0;
+    std::filesystem::file_time_type modified = std::filesystem::last_write_time(iniPath, ec);
+    if(ec || std::filesystem::file_time_type::clock::now() - modified < kStampSettle) return 0;
+    int64_t ticks = static_cast<int64_t>(modified.time_since_epoch().count());
+    uint64_t h = HashBytes(&kProfileCacheVersion, sizeof(kProfileCacheVersion));
+    h = HashBytes(&keys.hash, sizeof(keys.hash), h);
+    h = HashBytes(&size, sizeof(size), h);
+    h = HashBytes(&ticks, sizeof(ticks), h);
+    return h ? h : 1;
+}
+
+// ---- Compile ----
+std::vector<uint8_t> CompileProfile(const Profile &profile, uint64_t sourceHash, uint64_t sourceStamp,
+                                    const std::vector<ParseError> *errors){
+    std::string strings;
+    for(auto m : profile.macros) strings += m->definition + m->traceFile;
+    for(const auto &app : profile.apps) strings += app.name;
+    if(errors) for(const auto &e : *errors) strings += e.message;
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kProfileCacheVersion;
+    header.sourceHash = sourceHash;
+    header.macroCount = static_cast<uint32_t>(profile.macros.size());
+    header.entryCount = static_cast<uint32_t>(profile.dispatch.entries.size());
+    header.stringBytes = static_cast<uint32_t>(strings.size());
+    header.sequenceOpCount = static_cast<uint32_t>(profile.sequenceOps.size());
+    std::memcpy(header.pauseChord, profile.pauseChord.bits, sizeof(header.pauseChord));
+    header.appCount = static_cast<uint32_t>(profile.apps.size());
+    header.injectPriority = profile.injectPolicy.priority;
+    header.capturePriority = profile.capturePolicy.priority;
+    header.injectCores = profile.injectPolicy.cores;
+    header.captureCores = profile.capturePolicy.cores;
+    header.injectBudget = profile.injectBudget;
+    header.errorCount = errors ? static_cast<uint32_t>(errors->size()) : 0;
+    header.sourceStamp = sourceStamp;
+    CacheLayout layout(header.macroCount, header.sequenceOpCount, header.entryCount, header.appCount, header.errorCount,
+                       header.stringBytes);
+
+    std::vector<uint8_t> image(layout.total, 0);
+    std::memcpy(image.data(), &header, sizeof(header));
+    uint32_t offset = 0;
+    for(size_t i = 0; i < profile.macros.size(); ++i){
+        const Macro *m = profile.macros[i];
+        CacheMacro r;
+        std::memset(&r, 0, sizeof(r));
+        r.triggerCfg = m->triggerCfg;
+        r.targetCfg = m->targetCfg;
+        r.originalIntervalMs = m->originalIntervalMs;
+        r.periodNs = m->periodNs;
+        std::memcpy(r.chord, m->chord.bits, sizeof(r.chord));
+        for(int k = 0; k < 2; ++k){
+            r.ops[k].type = m->ops[k].type;
+            r.ops[k].vk = m->ops[k].vk;
+            r.ops[k].flags = m->ops[k].flags;
+            r.ops[k].mouseData = m->ops[k].mouseData;
+        }
+        r.definitionOffset = offset;
+        r.definitionLength = static_cast<uint32_t>(m->definition.size());
+        r.traceFileLength = static_cast<uint32_t>(m->traceFile.size());
+        r.wheelMode = m->wheelMode;
+        offset += r.definitionLength + r.traceFileLength;
+        r.sequenceBegin = m->sequenceBegin;
+        r.sequenceLength = m->sequenceLength;
+        r.action = static_cast<uint8_t>(m->action);
+        r.flags = (m->clickHold ? kFlagClickHold : 0)
+                | (m->keepOriginal ? kFlagKeepOriginal : 0)
+                | (m->dropOriginal ? kFlagDropOriginal : 0)
+                | (m->bindKeepOriginal ? kFlagBindKeepOriginal : 0)
+                | (m->bindDropOriginal ? kFlagBindDropOriginal : 0)
+                | (m->keyboardTarget ? kFlagKeyboardTarget : 0)
+                | (m->runOnce ? kFlagRunOnce : 0);
+        r.downCount = m->downCount;
+        r.upCount = m->upCount;
+        std::memcpy(image.data() + layout.macros + i * sizeof(CacheMacro), &r, sizeof(r));
+    }
+    for(uint32_t i = 0; i < header.sequenceOpCount; ++i){
+        const SeqOp &src = profile.sequenceOps[i];
+        SeqOp op = { src.code, 0, src.key, src.arg };
+        std::memcpy(image.data() + layout.sequence + i * sizeof(SeqOp), &op, sizeof(op));
+    }
+    std::memcpy(image.data() + layout.begin, profile.dispatch.begin, kBeginBytes);
+    // Field by field, so padding stays zero and equal profiles give identical images
+    for(uint32_t i = 0; i < header.entryCount; ++i){
+        DispatchEntry e;
+        std::memset(&e, 0, sizeof(e));
+        e.macroIndex = profile.dispatch.entries[i].macroIndex;
+        e.detectVK = profile.dispatch.entries[i].detectVK;
+        std::memcpy(image.data() + layout.entries + i * sizeof(DispatchEntry), &e, sizeof(e));
+    }
+    std::memcpy(image.data() + layout.suppress, profile.suppress, DispatchTable::kSlots);
+    for(uint32_t i = 0; i < header.appCount; ++i){
+        CacheApp a;
+        std::memset(&a, 0, sizeof(a));
+        a.nameOffset = offset;
+        a.nameLength = static_cast<uint32_t>(profile.apps[i].name.size());
+        a.kind = profile.apps[i].kind;
+        offset += a.nameLength;
+        std::memcpy(image.data() + layout.apps + i * sizeof(CacheApp), &a, sizeof(a));
+    }
+    for(uint32_t i = 0; i < header.errorCount; ++i){
+        const ParseError &src = (*errors)[i];
+        CacheError e = { static_cast<uint32_t>(src.line), static_cast<uint32_t>(src.column), offset,
+                         static_cast<uint32_t>(src.message.size()), src.warning ? uint8_t(1) : uint8_t(0), {} };
+        offset += e.messageLength;
+        std::memcpy(image.data() + layout.errors + i * sizeof(CacheError), &e, sizeof(e));
+    }
+    if(!strings.empty()) std::memcpy(image.data() + layout.strings, strings.data(), strings.size());
+    return image;
+}
+
+bool WriteCompiledProfile(const std::string &path, const Profile &profile, uint64_t sourceHash, uint64_t sourceStamp,
+                          const std::vector<ParseError> *errors){
+    std::vector<uint8_t> image = CompileProfile(profile, sourceHash, sourceStamp, errors);
+    // Write beside and rename over, so a concurrent loader never maps a half-written image
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if(!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if(!out.good()) return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+// ---- Load ----
+// Every program has to stay inside its own steps, so the engine never checks at run time
+static bool ValidSequence(const SeqOp *ops, uint32_t count, uint32_t begin, uint32_t length){
+    if(begin > count || length > count - begin || length > kMaxSequenceOps) return false;
+    for(uint32_t i = 0; i < length; ++i){
+        const SeqOp &op = ops[begin + i];
+        if(op.code == SeqOp::REPEAT && (op.key >= i || op.arg == 0)) return false;
+        if((op.code == SeqOp::DOWN || op.code == SeqOp::UP || op.code == SeqOp::CLICK) && op.key > 0xFF) return false;
+    }
+    return true;
+}
+
+uint64_t CompiledProfileHash(const uint8_t *data, size_t size, uint64_t sourceStamp){
+    if(!data || size < sizeof(CacheHeader) || !sourceStamp) return 0;
+    CacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if(std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.version != kProfileCacheVersion
+       || header.sourceStamp != sourceStamp) return 0;
+    return header.sourceHash;
+}
+
+bool LoadCompiledProfile(const uint8_t *data, size_t size, uint64_t sourceHash, Profile &out,
+                         std::vector<ParseError> *errors){
+    if(!data || size < sizeof(CacheHeader)) return false;
+    CacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if(std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0) return false;
+    if(header.version != kProfileCacheVersion || header.sourceHash != sourceHash) return false;
+    if(header.macroCount > kMaxMacros || header.entryCount > header.macroCount) return false;
+    if(header.sequenceOpCount > size / sizeof(SeqOp) || header.appCount > size / sizeof(CacheApp)
+       || header.errorCount > size / sizeof(CacheError)) return false;
+    if(header.injectPriority > ThreadPolicy::REALTIME || header.capturePriority > ThreadPolicy::REALTIME) return false;
+    if(header.injectBudget > kMaxInjectBudget) return false;
+    CacheLayout layout(header.macroCount, header.sequenceOpCount, header.entryCount, header.appCount, header.errorCount,
+                       header.stringBytes);
+    if(layout.total != size) return false;
+    const CacheError *rejected = reinterpret_cast<const CacheError*>(data + layout.errors);
+    for(uint32_t i = 0; i < header.errorCount; ++i){
+        const CacheError &e = rejected[i];
+        if(e.messageOffset > header.stringBytes || e.messageLength > header.stringBytes - e.messageOffset) return false;
+    }
+
+    const SeqOp *program = reinterpret_cast<const SeqOp*>(data + layout.sequence);
+    for(uint32_t i = 0; i < header.sequenceOpCount; ++i){
+        if(program[i].code > SeqOp::REPEAT) return false;
+    }
+
+    uint16_t begin[DispatchTable::kSlots + 1];
+    std::memcpy(begin, data + layout.begin, kBeginBytes);
+    if(begin[0] != 0) return false;
+    for(int v = 0; v < DispatchTable::kSlots; ++v){
+        if(begin[v+1] < begin[v]) return false;
+    }
+    if(begin[DispatchTable::kSlots] != header.entryCount) return false;
+
+    // Every section is checked before out is touched, so a rejected image leaves it as it
+    // was and a parse can fall back on it
+    const CacheMacro *records = reinterpret_cast<const CacheMacro*>(data + layout.macros);
+    for(uint32_t i = 0; i < header.macroCount; ++i){
+        const CacheMacro &r = records[i];
+        if(r.definitionOffset > header.stringBytes || r.definitionLength > header.stringBytes - r.definitionOffset
+           || r.traceFileLength > header.stringBytes - r.definitionOffset - r.definitionLength
+           || r.action > Macro::ACTION_REPLAY || r.downCount > 1 || r.upCount > 1 || r.wheelMode > Macro::WHEEL_SMOOTH
+           || !ValidSequence(program, header.sequenceOpCount, r.sequenceBegin, r.sequenceLength)) return false;
+    }
+    const DispatchEntry *entries = reinterpret_cast<const DispatchEntry*>(data + layout.entries);
+    for(uint32_t i = 0; i < header.entryCount; ++i){
+        if(entries[i].macroIndex >= header.macroCount) return false;
+    }
+    const CacheApp *apps = reinterpret_cast<const CacheApp*>(data + layout.apps);
+    for(uint32_t i = 0; i < header.appCount; ++i){
+        const CacheApp &a = apps[i];
+        if(a.nameOffset > header.stringBytes || a.nameLength > header.stringBytes - a.nameOffset
+           || a.kind > AppMatch::WINDOW_CLASS) return false;
+    }
+
+    const char *strings = reinterpret_cast<const char*>(data + layout.strings);
+    out.macroArena.Reserve(header.macroCount);
+    for(uint32_t i = 0; i < header.macroCount; ++i){
+        const CacheMacro &r = records[i];
+        Macro *m = out.NewMacro();
+        m->definition.assign(strings + r.definitionOffset, r.definitionLength);
+        m->traceFile.assign(strings + r.definitionOffset + r.definitionLength, r.traceFileLength);
+        m->action = static_cast<Macro::ActionType>(r.action);
+        m->clickHold = (r.flags & kFlagClickHold) != 0;
+        m->keepOriginal = (r.flags & kFlagKeepOriginal) != 0;
+        m->dropOriginal = (r.flags & kFlagDropOriginal) != 0;
+        m->bindKeepOriginal = (r.flags & kFlagBindKeepOriginal) != 0;
+        m->bindDropOriginal = (r.flags & kFlagBindDropOriginal) != 0;
+        m->keyboardTarget = (r.flags & kFlagKeyboardTarget) != 0;
+        m->runOnce = (r.flags & kFlagRunOnce) != 0;
+        m->sequenceBegin = r.sequenceBegin;
+        m->sequenceLength = r.sequenceLength;
+        m->triggerCfg = r.triggerCfg;
+        m->targetCfg = r.targetCfg;
+        m->originalIntervalMs = r.originalIntervalMs;
+        m->periodNs = r.periodNs;
+        m->wheelMode = static_cast<Macro::WheelMode>(r.wheelMode);
+        std::memcpy(m->chord.bits, r.chord, sizeof(r.chord));
+        m->ops[0] = r.ops[0];
+        m->ops[1] = r.ops[1];
+        m->downCount = r.downCount;
+        m->upCount = r.upCount;
+    }
+
+    std::memcpy(out.dispatch.begin, begin, kBeginBytes);
+    out.dispatch.entries.assign(entries, entries + header.entryCount);
+    std::memcpy(out.suppress, data + layout.suppress, DispatchTable::kSlots);
+    out.sequenceOps.assign(program, program + header.sequenceOpCount);
+    std::memcpy(out.pauseChord.bits, header.pauseChord, sizeof(header.pauseChord));
+    out.injectPolicy.priority = static_cast<ThreadPolicy::Priority>(header.injectPriority);
+    out.injectPolicy.cores = header.injectCores;
+    out.capturePolicy.priority = static_cast<ThreadPolicy::Priority>(header.capturePriority);
+    out.capturePolicy.cores = header.captureCores;
+    out.injectBudget = header.injectBudget;
+    for(auto m : out.macros) out.chordKeys |= ChordEventKeys(m->chord);
+    for(uint32_t i = 0; i < header.appCount; ++i){
+        const CacheApp &a = apps[i];
+        out.apps.push_back(AppMatch{ static_cast<AppMatch::Kind>(a.kind), std::string(strings + a.nameOffset, a.nameLength) });
+    }
+    if(errors){
+        for(uint32_t i = 0; i < header.errorCount; ++i){
+            const CacheError &e = rejected[i];
+            errors->push_back(ParseError{ e.line, e.column, std::string(strings + e.messageOffset, e.messageLength), e.warning != 0 });
+        }
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+
+#include "Profile.h"
+#include "KeyMap.h"
+#include "Hash.h"
+
+// ---- Compiled profile cache ----
+// A parsed .ini stored as a flat binary image next to its source (<name>.ini.umc):
+// resolved macros with their compiled injection ops, the dispatch and suppress tables,
+// the definition strings used to diff reloads, the trace file names of [Replay]
+// macros, the thread settings, the injection budget and the lines the parser rejected.
+// The header carries a hash of the .ini text and the keymap, so a stale or foreign
+// image is simply ignored, plus a stamp of the .ini's size and modification time so an
+// untouched source need not be read to tell. Loading an image is a bounds check plus a
+// copy per macro; no text is parsed.
+//
+//   header | CacheMacro[macroCount] | SeqOp[sequenceOpCount] | begin[257] | DispatchEntry[entryCount] | suppress[256] | CacheApp[appCount] | CacheError[errorCount] | strings
+
+static const uint32_t kProfileCacheVersion = 11;
+
+// Identifies what a compiled image was built from
+uint64_t ProfileSourceHash(std::string_view iniText, const KeyMap &keys);
+// The .ini's size and modification time with the keymap; 0 if the file cannot be read
+// or was written so recently that another edit could still share its timestamp
+uint64_t ProfileSourceStamp(const std::string &iniPath, const KeyMap &keys);
+
+inline std::string CompiledProfilePath(const std::string &iniPath){ return iniPath + ".umc"; }
+
+std::vector<uint8_t> CompileProfile(const Profile &profile, uint64_t sourceHash, uint64_t sourceStamp = 0,
+                                    const std::vector<ParseError> *errors = nullptr);
+bool WriteCompiledProfile(const std::string &path, const Profile &profile, uint64_t sourceHash, uint64_t sourceStamp = 0,
+                          const std::vector<ParseError> *errors = nullptr);
+// Rebuilds a profile from an image, appending the lines its source rejected to errors;
+// false, with out and errors left untouched, if it is malformed, from another version
+// or was not built from sourceHash
+bool LoadCompiledProfile(const uint8_t *data, size_t size, uint64_t sourceHash, Profile &out,
+                         std::vector<ParseError> *errors = nullptr);
+// The source hash of an image stamped with sourceStamp, 0 for any other image
+uint64_t CompiledProfileHash(const uint8_t *data, size_t size, uint64_t sourceStamp);
+
+enum class CacheResult { FAILED, HIT, REBUILT };
+
+// Loads an .ini through its compiled image when that is current, otherwise parses the
+// text and rewrites the image. Rejected lines go to errors either way. An .ini whose
+// stamp matches the image is never opened; one that was only touched is hashed and its
+// image restamped. MappedFile is the platform's read-only file mapping
+// (Open/Close/Data/Size), e.g. Win32MappedFile or LinuxMappedFile.
+template <typename MappedFile>
+CacheResult LoadProfileCached(const std::string &iniPath, const KeyMap &keys, Profile &out,
+                              std::vector<ParseError> *errors = nullptr){
+    std::string cachePath = CompiledProfilePath(iniPath);
+    uint64_t stamp = ProfileSourceStamp(iniPath, keys);
+    if(stamp){
+        MappedFile image;
+        if(image.Open(cachePath)){
+            uint64_t hash = CompiledProfileHash(image.Data(), image.Size(), stamp);
+            if(hash && LoadCompiledProfile(image.Data(), image.Size(), hash, out, errors)) return CacheResult::HIT;
+        }
+    }
+
+    MappedFile ini;
+    std::string_view source;
+    if(ini.Open(iniPath)) source = std::string_view(reinterpret_cast<const char*>(ini.Data()), ini.Size());
+    else if(!std::ifstream(iniPath).is_open()) return CacheResult::FAILED;
+    uint64_t hash = ProfileSourceHash(source, keys);
+    std::vector<ParseError> rejected;
+    CacheResult result = CacheResult::REBUILT;
+    {
+        MappedFile image;
+        if(image.Open(cachePath) && LoadCompiledProfile(image.Data(), image.Size(), hash, out, &rejected)){
+            result = CacheResult::HIT;
+        }
+    }
+    if(result == CacheResult::REBUILT) ParseMacros(source, keys, out, &rejected);
+    if(result == CacheResult::REBUILT || stamp) WriteCompiledProfile(cachePath, out, hash, stamp, &rejected);
+    if(errors) errors->insert(errors->end(), rejected.begin(), rejected.end());
+    return result;
+}
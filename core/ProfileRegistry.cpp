@@ -0,0 +1,67 @@
+#include "ProfileRegistry.h"
+#include "KeyMap.h"
+
+ProfileRegistry::~ProfileRegistry(){
+    for(auto &e : entries) engine.ReleaseProfile(e.profile);
+}
+
+void ProfileRegistry::Put(const std::string &name, const std::string &path, Profile *profile){
+    size_t index = Find(name);
+    if(index == npos){
+        // Kept in name order, as the tray lists them
+        size_t at = 0;
+        while(at < entries.size() && toLowerStr(entries[at].name) < toLowerStr(name)) ++at;
+        entries.insert(entries.begin() + at, Entry{ name, path, profile });
+        if(active != npos && active >= at) ++active;
+    } else {
+        Profile *old = entries[index].profile;
+        entries[index].path = path;
+        entries[index].profile = profile;
+        // Released first, so the engine treats the swap as a reload of the same profile
+        engine.ReleaseProfile(old);
+        if(index == active) engine.UseProfile(profile);
+    }
+    RebuildAppIndex();
+}
+
+void ProfileRegistry::Remove(const std::string &name){
+    size_t index = Find(name);
+    if(index == npos) return;
+    engine.ReleaseProfile(entries[index].profile);
+    entries.erase(entries.begin() + index);
+    if(active == index) active = npos;
+    else if(active != npos && active > index) --active;
+    RebuildAppIndex();
+}
+
+size_t ProfileRegistry::Find(const std::string &name) const {
+    for(size_t i = 0; i < entries.size(); ++i){
+        if(EqualsCI(entries[i].name, name)) return i;
+    }
+    return npos;
+}
+
+size_t ProfileRegistry::Match(const std::string &exe, const std::string &windowClass) const {
+    auto it = byExe.find(toLowerStr(exe));
+    if(it != byExe.end()) return it->second;
+    it = byClass.find(toLowerStr(windowClass));
+    return it != byClass.end() ? it->second : npos;
+}
+
+void ProfileRegistry::Activate(size_t index){
+    if(index >= entries.size() || index == active) return;
+    active = index;
+    engine.UseProfile(entries[index].profile);
+}
+
+// First declaration wins when two profiles claim the same application
+void ProfileRegistry::RebuildAppIndex(){
+    byExe.clear();
+    byClass.clear();
+    for(size_t i = 0; i < entries.size(); ++i){
+        for(const auto &app : entries[i].profile->apps){
+            auto &index = app.kind == AppMatch::EXE ? byExe : byClass;
+            index.emplace(app.name, i);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Engine.h"
+#include "Profile.h"
+
+// ---- Resident profiles ----
+// Every profile of the CFG folder, parsed once and kept in memory, indexed by the
+// applications each one declares. Activating one is a lookup plus Engine::UseProfile,
+// so following the foreground window never touches the disk. The registry owns its
+// profiles and hands replaced ones back to the engine, which frees them once unused.
+// Control thread only; destroy it before the engine.
+class ProfileRegistry {
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    struct Entry {
+        // File name as listed in the tray ("dh1.ini") and the path it was loaded from
+        std::string name;
+        std::string path;
+        Profile *profile;
+    };
+
+    explicit ProfileRegistry(Engine &engine) : engine(engine) {}
+    ~ProfileRegistry();
+    ProfileRegistry(const ProfileRegistry&) = delete;
+    ProfileRegistry& operator=(const ProfileRegistry&) = delete;
+
+    // Adds name's profile or replaces it, taking ownership; entries stay sorted by name.
+    // If the replaced profile is the active one, the engine switches to the new one and
+    // carries its state over.
+    void Put(const std::string &name, const std::string &path, Profile *profile);
+    // Drops name's profile. If it is active the engine keeps running it, now as its
+    // own, until another one is activated.
+    void Remove(const std::string &name);
+
+    // Index of name (case-insensitive), or npos
+    size_t Find(const std::string &name) const;
+    // Index of the profile that declares the executable (file name) or the window
+    // class, or npos. An [App] executable match wins over a class match.
+    size_t Match(const std::string &exe, const std::string &windowClass) const;
+
+    // Switches the engine to entry index; a no-op if it is already active
+    void Activate(size_t index);
+    size_t Active() const { return active; }
+
+    const std::vector<Entry> &Entries() const { return entries; }
+
+private:
+    void RebuildAppIndex();
+
+    Engine &engine;
+    std::vector<Entry> entries;
+    // Lowercased executable names and window classes to entry index
+    std::unordered_map<std::string, size_t> byExe;
+    std::unordered_map<std::string, size_t> byClass;
+    size_t active = npos;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+// ---- Deadline heap ----
+// Min-heap of absolute due times, one entry per scheduled macro. Only the engine's
+// scheduler thread touches it.
+template <typename T>
+struct DeadlineHeap {
+    struct Entry {
+        uint64_t dueNs;
+        T item;
+    };
+
+    std::vector<Entry> heap;
+
+    bool Empty() const { return heap.empty(); }
+    size_t Size() const { return heap.size(); }
+    uint64_t NextDue() const { return heap.front().dueNs; }
+    const Entry &Top() const { return heap.front(); }
+
+    void Push(uint64_t dueNs, T item){
+        heap.push_back(Entry{ dueNs, item });
+        std::push_heap(heap.begin(), heap.end(), Later);
+    }
+    Entry Pop(){
+        std::pop_heap(heap.begin(), heap.end(), Later);
+        Entry e = heap.back();
+        heap.pop_back();
+        return e;
+    }
+    void Clear(){ heap.clear(); }
+
+private:
+    static bool Later(const Entry &a, const Entry &b){ return a.dueNs > b.dueNs; }
+};
@@ -0,0 +1,103 @@
+#include "Stats.h"
+#include "Engine.h"
+#include "KeyMap.h"
+
+#include <cstdio>
+
+static double Us(uint64_t ns){
+    return static_cast<double>(ns) / 1000.0;
+}
+
+// Theoretical and achieved clicks per second of an autoclicker
+static double TargetCps(const Macro *m){
+    return m->periodNs ? 1e9 / static_cast<double>(m->periodNs) : 0.0;
+}
+static double AchievedCps(const Macro *m){
+    uint64_t active = m->stats.activeNs.load(std::memory_order_relaxed);
+    return active ? static_cast<double>(m->stats.clicks.load(std::memory_order_relaxed)) * 1e9 / static_cast<double>(active) : 0.0;
+}
+
+// ---- Console table ----
+void WriteStatsTable(const Engine &engine, std::ostream &out){
+    char line[256];
+    const Profile *profile = engine.GetProfile();
+    std::snprintf(line, sizeof(line), "%3s %-9s %4s %4s %9s %9s %10s %10s %7s %9s %9s %9s %9s\n",
+                  "#", "action", "trg", "tgt", "cps", "actual", "clicks", "fires", "missed", "throttled",
+                  "late p50", "late p99", "late max");
+    out << line;
+    if(profile){
+        for(size_t i = 0; i < profile->macros.size(); ++i){
+            const Macro *m = profile->macros[i];
+            const MacroStats &st = m->stats;
+            std::snprintf(line, sizeof(line), "%3zu %-9s %4u %4u %9.1f %9.1f %10llu %10llu %7llu %9llu %9.1f %9.1f %9.1f\n",
+                          i + 1, ActionName(m->action), m->triggerCfg, m->targetCfg,
+                          TargetCps(m), AchievedCps(m),
+                          (unsigned long long)st.clicks.load(std::memory_order_relaxed),
+                          (unsigned long long)st.fires.load(std::memory_order_relaxed),
+                          (unsigned long long)st.missed.load(std::memory_order_relaxed),
+                          (unsigned long long)st.throttled.load(std::memory_order_relaxed),
+                          Us(st.lateness.Percentile(0.50)), Us(st.lateness.Percentile(0.99)), Us(st.lateness.Max()));
+            out << line;
+        }
+    }
+    const LatencyHistogram &hook = engine.hookResidency;
+    const LatencyHistogram &send = engine.sendDuration;
+    std::snprintf(line, sizeof(line), "hook: %llu events, p50 %.1f us, p99 %.1f us, max %.1f us, %llu dropped\n",
+                  (unsigned long long)hook.Count(), Us(hook.Percentile(0.50)), Us(hook.Percentile(0.99)), Us(hook.Max()),
+                  (unsigned long long)engine.ringOverflows.load());
+    out << line;
+    std::snprintf(line, sizeof(line), "send: %llu calls, p50 %.1f us, p99 %.1f us, max %.1f us, %llu ticks skipped\n",
+                  (unsigned long long)send.Count(), Us(send.Percentile(0.50)), Us(send.Percentile(0.99)), Us(send.Max()),
+                  (unsigned long long)engine.missedTicks.load());
+    out << line;
+    if(profile && profile->injectBudget){
+        std::snprintf(line, sizeof(line), "budget: %u events/s, %llu clicks throttled\n", profile->injectBudget,
+                      (unsigned long long)engine.throttledClicks.load());
+        out << line;
+    }
+    uint32_t workerRefused = engine.workerPolicyFailures.load(), inputRefused = engine.inputPolicyFailures.load();
+    if(workerRefused || inputRefused){
+        std::snprintf(line, sizeof(line), "threads: priority or cores refused %u times for the worker, %u for the input thread\n",
+                      workerRefused, inputRefused);
+        out << line;
+    }
+}
+
+// ---- CSV ----
+// One row per macro, then the engine-wide histograms as pseudo-rows, all in microseconds
+void WriteStatsCsv(const Engine &engine, std::ostream &out){
+    out << "index,action,trigger,target,definition,target_cps,actual_cps,clicks,fires,missed,throttled,active_ms,"
+           "late_p50_us,late_p90_us,late_p99_us,late_max_us\n";
+    const Profile *profile = engine.GetProfile();
+    char line[256];
+    if(profile){
+        for(size_t i = 0; i < profile->macros.size(); ++i){
+            const Macro *m = profile->macros[i];
+            const MacroStats &st = m->stats;
+            std::string def = m->definition;
+            for(size_t q = def.find('"'); q != std::string::npos; q = def.find('"', q + 2)) def.insert(q, 1, '"');
+            std::string action = toLowerStr(ActionName(m->action));
+            std::snprintf(line, sizeof(line), "%zu,%s,%u,%u,", i + 1, action.c_str(), m->triggerCfg, m->targetCfg);
+            out << line << '"' << def << '"';
+            std::snprintf(line, sizeof(line), ",%.3f,%.3f,%llu,%llu,%llu,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                          TargetCps(m), AchievedCps(m),
+                          (unsigned long long)st.clicks.load(std::memory_order_relaxed),
+                          (unsigned long long)st.fires.load(std::memory_order_relaxed),
+                          (unsigned long long)st.missed.load(std::memory_order_relaxed),
+                          (unsigned long long)st.throttled.load(std::memory_order_relaxed),
+                          static_cast<double>(st.activeNs.load(std::memory_order_relaxed)) / 1e6,
+                          Us(st.lateness.Percentile(0.50)), Us(st.lateness.Percentile(0.90)),
+                          Us(st.lateness.Percentile(0.99)), Us(st.lateness.Max()));
+            out << line;
+        }
+    }
+    const struct { const char *name; const LatencyHistogram &h; } engineRows[] = {
+        { "hook", engine.hookResidency },
+        { "send", engine.sendDuration },
+    };
+    for(auto &r : engineRows){
+        std::snprintf(line, sizeof(line), "0,%s,,,,,,%llu,,,,,%.3f,%.3f,%.3f,%.3f\n", r.name, (unsigned long long)r.h.Count(),
+                      Us(r.h.Percentile(0.50)), Us(r.h.Percentile(0.90)), Us(r.h.Percentile(0.99)), Us(r.h.Max()));
+        out << line;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+#include "LatencyHistogram.h"
+
+class Engine;
+
+// ---- Per-macro statistics ----
+// Written by the engine's worker with relaxed atomics and readable from any thread
+// while macros run; the cost per click is a few uncontended increments.
+struct MacroStats {
+    // Autoclick ticks fired / clicks (or bind presses) delivered / ticks skipped for lateness
+    std::atomic<uint64_t> fires{0};
+    std::atomic<uint64_t> clicks{0};
+    std::atomic<uint64_t> missed{0};
+    // Clicks dropped because the macro had used up its share of the injection budget
+    std::atomic<uint64_t> throttled{0};
+    // Time spent active, up to the latest fire; clicks / activeNs is the achieved rate
+    std::atomic<uint64_t> activeNs{0};
+    // Submission time minus scheduled due time of every fire
+    LatencyHistogram lateness;
+
+    // Worker-only bookkeeping for activeNs
+    uint64_t runStartNs = 0;
+    uint64_t activeBaseNs = 0;
+
+    void Merge(const MacroStats &other){
+        fires.fetch_add(other.fires.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        clicks.fetch_add(other.clicks.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        missed.fetch_add(other.missed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        throttled.fetch_add(other.throttled.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        activeNs.fetch_add(other.activeNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        lateness.Merge(other.lateness);
+        runStartNs = other.runStartNs;
+        activeBaseNs += other.activeBaseNs;
+    }
+};
+
+// ---- Reports ----
+// Snapshot of the engine's published profile: one row per macro plus the engine-wide
+// hook and injection timings. Call from the control thread (same rule as GetProfile).
+void WriteStatsTable(const Engine &engine, std::ostream &out);
+void WriteStatsCsv(const Engine &engine, std::ostream &out);
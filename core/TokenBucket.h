@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+// ---- Token bucket ----
+// Refills at ratePerSec events per second up to burst events. The level is kept in
+// billionths of an event so that a refill of any length adds exactly rate * elapsed ns,
+// and low rates do not round down to nothing between frequent refills. A rate of 0
+// means no limit. Used from the engine's worker thread only.
+class TokenBucket {
+public:
+    bool Limited() const { return ratePerSec != 0; }
+    uint64_t Rate() const { return ratePerSec; }
+
+    // Changes the rate keeping what has accrued so far; a bucket that was unlimited starts full
+    void SetRate(uint64_t rate, uint64_t burstEvents, uint64_t nowNs){
+        Refill(nowNs);
+        bool wasLimited = Limited();
+        ratePerSec = rate;
+        capacity = (burstEvents ? burstEvents : 1) * kScale;
+        if(!wasLimited || level > capacity) level = capacity;
+    }
+
+    void Refill(uint64_t nowNs){
+        uint64_t elapsed = nowNs > lastNs ? nowNs - lastNs : 0;
+        lastNs = nowNs;
+        if(!Limited()) return;
+        uint64_t room = capacity - level;
+        level = elapsed >= room / ratePerSec ? capacity : level + elapsed * ratePerSec;
+    }
+
+    uint64_t Available() const { return Limited() ? level / kScale : UINT64_MAX; }
+
+    // Spends count events; more than is available empties the bucket
+    void Take(uint64_t count){
+        if(!Limited()) return;
+        level = count >= level / kScale ? level % kScale : level - count * kScale;
+    }
+
+private:
+    static const uint64_t kScale = 1000000000;
+
+    uint64_t ratePerSec = 0;
+    uint64_t capacity = kScale;
+    uint64_t level = 0;
+    uint64_t lastNs = 0;
+};
@@ -0,0 +1,25 @@
+#include "Trace.h"
+
+#include <cstring>
+
+static const char kTraceMagic[4] = { 'U', 'M', 'T', 'R' };
+
+TraceHeader MakeTraceHeader(uint64_t startNs){
+    TraceHeader header = {};
+    std::memcpy(header.magic, kTraceMagic, sizeof(kTraceMagic));
+    header.version = kTraceVersion;
+    header.recordSize = sizeof(TraceRecord);
+    header.startNs = startNs;
+    return header;
+}
+
+bool ViewTrace(const uint8_t *data, size_t size, const TraceRecord *&records, size_t &count){
+    if(!data || size < sizeof(TraceHeader) || reinterpret_cast<uintptr_t>(data) % alignof(TraceRecord) != 0) return false;
+    TraceHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if(std::memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)) != 0) return false;
+    if(header.version != kTraceVersion || header.recordSize != sizeof(TraceRecord)) return false;
+    records = reinterpret_cast<const TraceRecord*>(data + sizeof(TraceHeader));
+    count = (size - sizeof(TraceHeader)) / sizeof(TraceRecord);
+    return true;
+}
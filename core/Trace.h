@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// ---- Input traces (.umt) ----
+// A recorded input session: a header, then one fixed-size record per key, button or
+// wheel event. Records are only ever appended, so a recording cut short is still a
+// valid trace up to its last whole record. Times are nanoseconds since the recording
+// started, at the resolution of the clock that stamped them (QPC on Windows).
+//
+//   header | TraceRecord[(size - header) / recordSize]
+
+static const uint16_t kTraceVersion = 1;
+
+struct TraceHeader {
+    char     magic[4];
+    uint16_t version;
+    uint16_t recordSize;
+    // Clock time the recording started at, for reference only
+    uint64_t startNs;
+    uint64_t reserved[2];
+};
+
+struct TraceRecord {
+    enum Kind : uint8_t { KEY = 0, BUTTON = 1, WHEEL = 2 };
+    uint64_t timeNs;
+    uint8_t  kind;
+    // KEY, BUTTON: the VK and whether it went down
+    uint8_t  vk;
+    uint8_t  down;
+    uint8_t  reserved;
+    // WHEEL: distance in WHEEL_DELTA units (120 per notch), positive away from the user
+    int32_t  wheel;
+};
+
+static_assert(sizeof(TraceHeader) == 32 && sizeof(TraceRecord) == 16, "trace records are written byte for byte");
+
+TraceHeader MakeTraceHeader(uint64_t startNs);
+// Validates a trace image and points records at its events; false if it is not a trace
+// of this version. data must be 8-byte aligned, as a file mapping is.
+bool ViewTrace(const uint8_t *data, size_t size, const TraceRecord *&records, size_t &count);
+
+// Events of one trace held in memory by whatever loaded them. A [Replay] macro points
+// at one of these, owned by its profile.
+class TraceData {
+public:
+    virtual ~TraceData() = default;
+    // Time of the last event, the length of one pass
+    uint64_t DurationNs() const { return count ? records[count - 1].timeNs : 0; }
+
+    const TraceRecord *records = nullptr;
+    size_t count = 0;
+};
+
+// A trace file mapped read-only. MappedFile is the platform's file mapping
+// (Open/Close/Data/Size), as for LoadProfileCached.
+template <typename MappedFile>
+class MappedTrace : public TraceData {
+public:
+    bool Open(const std::string &path){
+        if(file.Open(path) && ViewTrace(file.Data(), file.Size(), records, count)) return true;
+        file.Close();
+        return false;
+    }
+
+private:
+    MappedFile file;
+};
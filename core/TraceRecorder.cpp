@@ -0,0 +1,79 @@
+#include "TraceRecorder.h"
+
+#include <chrono>
+
+bool TraceRecorder::Start(const std::string &path, uint64_t start){
+    if(writer.joinable()) return false;
+    file = std::fopen(path.c_str(), "wb");
+    if(!file) return false;
+    TraceHeader header = MakeTraceHeader(start);
+    if(std::fwrite(&header, sizeof(header), 1, file) != 1 || std::fflush(file) != 0){
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    // Leftovers pushed while the last trace was being stopped
+    TraceRecord stale;
+    while(ring.TryPop(stale)) {}
+    startNs = start;
+    writeFailed = false;
+    recorded.store(0);
+    dropped.store(0);
+    // Publishes startNs to the hook thread, which reads it after an acquire load
+    recording.store(true, std::memory_order_release);
+    writer = std::thread(&TraceRecorder::Run, this);
+    return true;
+}
+
+void TraceRecorder::Stop(){
+    if(!writer.joinable()) return;
+    recording.store(false);
+    writer.join();
+    std::fclose(file);
+    file = nullptr;
+}
+
+// Hook side: one ring push, whatever the writer is doing
+bool TraceRecorder::OnInput(const InputEvent &ev){
+    if(recording.load(std::memory_order_acquire)){
+        TraceRecord r = {};
+        r.timeNs = ev.timeNs > startNs ? ev.timeNs - startNs : 0;
+        if(ev.wheel){
+            r.kind = TraceRecord::WHEEL;
+            r.wheel = ev.wheel;
+        } else {
+            bool button = ev.vk == kVkLButton || ev.vk == kVkRButton || ev.vk == kVkMButton
+                       || ev.vk == kVkXButton1 || ev.vk == kVkXButton2;
+            r.kind = button ? TraceRecord::BUTTON : TraceRecord::KEY;
+            r.vk = ev.vk;
+            r.down = ev.down ? 1 : 0;
+        }
+        if(ring.TryPush(r)) recorded.fetch_add(1, std::memory_order_relaxed);
+        else dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    return next.OnInput(ev);
+}
+
+void TraceRecorder::Run(){
+    while(recording.load()){
+        std::this_thread::sleep_for(std::chrono::nanoseconds(flushIntervalNs));
+        Drain();
+    }
+    Drain();
+}
+
+// Appends everything in the ring and flushes, so a crash loses at most one interval.
+// After a failed write the ring is still emptied but nothing more is written.
+void TraceRecorder::Drain(){
+    size_t n = 0;
+    for(;;){
+        bool more = ring.TryPop(chunk[n]);
+        if(more) ++n;
+        if(n == sizeof(chunk) / sizeof(chunk[0]) || (!more && n)){
+            if(!writeFailed && std::fwrite(chunk, sizeof(TraceRecord), n, file) != n) writeFailed = true;
+            n = 0;
+        }
+        if(!more) break;
+    }
+    if(!writeFailed && std::fflush(file) != 0) writeFailed = true;
+}
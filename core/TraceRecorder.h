@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "Backend.h"
+#include "EventRing.h"
+#include "Trace.h"
+
+// ---- Trace recording ----
+// Sits between an input source and its handler and passes every event on unchanged.
+// While recording, each event is also stamped into a lock-free ring that a writer
+// thread drains to the trace file every few milliseconds, so the hook never waits on
+// the disk. Should the writer fall a whole ring behind, events are dropped and counted
+// rather than blocking the hook.
+class TraceRecorder : public IInputHandler {
+public:
+    explicit TraceRecorder(IInputHandler &next) : next(next) {}
+    ~TraceRecorder(){ Stop(); }
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // Starts a new trace at path; event times are taken relative to startNs, the
+    // input clock's now. Control thread only, like Stop.
+    bool Start(const std::string &path, uint64_t startNs);
+    // Writes out whatever is still buffered and closes the trace
+    void Stop();
+    bool Recording() const { return recording.load(); }
+    // Whether the last trace lost events to a failed write; valid once stopped
+    bool WriteFailed() const { return writeFailed; }
+
+    bool OnInput(const InputEvent &ev) override;
+
+    // How often the writer drains the ring to the file
+    uint64_t flushIntervalNs = 5000000;
+
+    // Events of the current trace handed to the writer, and lost to a full ring
+    std::atomic<uint64_t> recorded{0};
+    std::atomic<uint64_t> dropped{0};
+
+private:
+    void Run();
+    void Drain();
+
+    IInputHandler &next;
+    std::atomic_bool recording{false};
+    uint64_t startNs = 0;
+    std::FILE *file = nullptr;
+    bool writeFailed = false;
+    std::thread writer;
+    EventRing<TraceRecord, 16384> ring;
+    TraceRecord chunk[512];
+};
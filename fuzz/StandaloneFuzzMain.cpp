@@ -0,0 +1,49 @@
+// Minimal driver for LLVMFuzzerTestOneInput when libFuzzer is not available: runs every
+// file named on the command line, then a fixed number of random byte mutations of them.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int main(int argc, char **argv){
+    long runs = 100000;
+    std::vector<std::string> corpus;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg.compare(0, 6, "-runs=") == 0){
+            runs = std::strtol(arg.c_str() + 6, nullptr, 10);
+            continue;
+        }
+        std::ifstream in(arg, std::ios::binary);
+        std::ostringstream text;
+        text << in.rdbuf();
+        corpus.push_back(text.str());
+    }
+    if(corpus.empty()) corpus.push_back("[AutoClick] [HOLD] [K] \"mouse4\" \"lmb\" [10]\n[Bind] \"x\" \"enter\"\n");
+    for(const auto &c : corpus) LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(c.data()), c.size());
+
+    static const char kAlphabet[] = "[]\"#; \t\r\nabcdefhiklmnoprstuxAKDHT0123456789.-+eE";
+    std::mt19937 rng(12345);
+    for(long r = 0; r < runs; ++r){
+        std::string s = corpus[r % corpus.size()];
+        int mutations = 1 + rng() % 8;
+        for(int m = 0; m < mutations; ++m){
+            size_t p = s.empty() ? 0 : rng() % s.size();
+            switch(rng() % 4){
+                case 0: if(!s.empty()) s[p] = kAlphabet[rng() % (sizeof(kAlphabet) - 1)]; break;
+                case 1: if(!s.empty()) s.erase(p, 1 + rng() % 8); break;
+                case 2: s.insert(p, 1, kAlphabet[rng() % (sizeof(kAlphabet) - 1)]); break;
+                case 3: if(!s.empty()) s[p] = static_cast<char>(rng()); break;
+            }
+        }
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+    std::printf("%zu inputs, %ld mutations: ok\n", corpus.size(), runs);
+    return 0;
+}
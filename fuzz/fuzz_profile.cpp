@@ -0,0 +1,77 @@
+// Fuzz target for the profile parser and the compiled-image loader (libFuzzer entry
+// point; StandaloneFuzzMain.cpp drives it on compilers without -fsanitize=fuzzer).
+// Any input must parse without crashing, every rejected line and every warning must be
+// reported with a position inside the input, and a parsed profile must survive an image round trip
+// together with its rejected lines. A profile an image failed to load into must parse
+// exactly as a fresh one does, as the cache falls back on it.
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "KeyMap.h"
+#include "Profile.h"
+#include "ProfileCache.h"
+
+static void Check(bool ok){
+    if(!ok) std::abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size){
+    static const KeyMap keys;
+    std::string_view text(reinterpret_cast<const char*>(data), size);
+
+    Profile parsed;
+    std::vector<ParseError> errors;
+    size_t skipped = ParseMacros(text, keys, parsed, &errors);
+    size_t warnings = 0;
+    for(const auto &e : errors) warnings += e.warning;
+    Check(skipped + warnings == errors.size());
+    size_t lines = 1;
+    for(char c : text) if(c == '\n') ++lines;
+    for(const auto &e : errors) Check(e.line >= 1 && e.line <= lines && e.column >= 1 && !e.message.empty());
+
+    Profile quiet;
+    Check(ParseMacros(text, keys, quiet) == skipped && quiet.macros.size() == parsed.macros.size());
+
+    for(int vk = 0; vk < DispatchTable::kSlots; ++vk){
+        if(parsed.dispatch.Empty(vk)) continue;
+        for(const DispatchEntry *e = parsed.dispatch.First(vk); e != parsed.dispatch.Last(vk); ++e){
+            Check(e->macroIndex < parsed.macros.size() && e->detectVK == vk);
+        }
+    }
+
+    std::vector<uint8_t> image = CompileProfile(parsed, 1, 0, &errors);
+    Profile loaded;
+    std::vector<ParseError> loadedErrors;
+    Check(LoadCompiledProfile(image.data(), image.size(), 1, loaded, &loadedErrors));
+    Check(loadedErrors.size() == errors.size() && CompileProfile(loaded, 1, 0, &loadedErrors) == image);
+
+    auto parsesClean = [&](Profile &target){
+        std::vector<ParseError> again;
+        ParseMacros(text, keys, target, &again);
+        Check(CompileProfile(target, 1, 0, &again) == image);
+    };
+
+    // A damaged copy of the image must be rejected or load cleanly, never crash
+    if(size > 0){
+        std::vector<uint8_t> damaged = image;
+        size_t at = HashBytes(data, size) % damaged.size();
+        damaged[at] ^= data[0] | 1;
+        Profile broken;
+        if(!LoadCompiledProfile(damaged.data(), damaged.size(), 1, broken)) parsesClean(broken);
+    }
+
+    // The same bytes as an image, copied to an aligned buffer as a mapping would be; the
+    // hash is taken from the input so the header check passes
+    if(size >= 16){
+        std::vector<uint64_t> aligned((size + 7) / 8);
+        std::memcpy(aligned.data(), data, size);
+        uint64_t hash;
+        std::memcpy(&hash, data + 8, sizeof(hash));
+        Profile raw;
+        if(!LoadCompiledProfile(reinterpret_cast<const uint8_t*>(aligned.data()), size, hash, raw)) parsesClean(raw);
+    }
+    return 0;
+}
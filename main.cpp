@@ -1,25 +1,22 @@
 #define UNICODE
 #include <windows.h>
-#include <mmsystem.h>
 #include <shellapi.h>
-#pragma comment(lib, "winmm.lib")
 
 #include <string>
 #include <vector>
 #include <fstream>
+#include <sstream>
 #include <iostream>
-#include <unordered_map>
-#include <algorithm>
-#include <cctype>
-#include <atomic>
 #include <cmath>
+#include <cstdio>
 
-#ifndef LLKHF_INJECTED
-#define LLKHF_INJECTED 0x10
-#endif
-#ifndef LLMHF_INJECTED
-#define LLMHF_INJECTED 0x00000001
-#endif
+#include "Engine.h"
+#include "KeyMap.h"
+#include "ProfileCache.h"
+#include "ProfileRegistry.h"
+#include "Stats.h"
+#include "TraceRecorder.h"
+#include "Win32Backend.h"
 
 #define WM_TRAYICON (WM_USER + 1)
 #define ID_TRAY_REFRESH 1001
@@ -27,34 +24,29 @@
 #define ID_TRAY_EXIT    1003
 #define ID_TRAY_INI_BASE 2000
 #define ID_TRAY_TOGGLE 1004
-
-struct Macro {
-    enum ActionType { ACTION_AUTOCLICK = 0, ACTION_BIND = 1 } action = ACTION_AUTOCLICK;
-    bool clickHold = true;
-    bool bindKeepOriginal = false;
-    bool bindDropOriginal = false;
-    bool keepOriginal = false;
-    bool dropOriginal = false;
-    DWORD triggerCfg = 0;
-    DWORD targetCfg = 0;
-    float originalIntervalMs = 0.0f;
-    float effectiveIntervalMs = 0.0f;
-    std::atomic_bool active{false};
-    std::atomic_bool bindTargetDown{false};
-    MMRESULT timerId{0};
-    int clicksPerTick = 1;
-};
-
-static std::vector<Macro*> macros;
-static std::unordered_map<std::string,int> keyMap;
-static std::atomic_bool isPaused{false};
-static bool key8Down = false;
-static bool key9Down = false;
-static bool key0Down = false;
-static ULONGLONG lastPauseToggle = 0;
-static const DWORD DEBOUNCE_MS = 500;
+#define ID_TRAY_STATS  1005
+#define ID_TRAY_STATS_CSV 1006
+#define ID_TRAY_RECORD 1007
+#define WM_CFG_CHANGED (WM_APP + 1)
+
+static KeyMap keyMap;
+static Win32Clock *sysClock = nullptr;
+static Win32InputSink injector;
+static Win32ThreadTuner threadTuner;
+// Low-level hooks, or Raw Input with --rawinput
+static IInputSource *capture = nullptr;
+static bool rawInput = false;
+static Engine *engine = nullptr;
+// Between the capture source and the engine; writes a trace while recording
+static TraceRecorder *recorder = nullptr;
+static Win32DirWatcher cfgWatcher;
+static Win32ForegroundWatcher focusWatcher;
+static ProfileRegistry *registry = nullptr;
+// CFG folder next to the executable, with a trailing separator
+static std::string cfgFolder;
+// Profile picked in the tray (or restored from last_config.txt); active whenever the
+// foreground application has no profile of its own
 static std::string currentIniPath;
-static std::vector<std::string> iniFiles;
 
 // Tray globals
 static NOTIFYICONDATA nid;
@@ -65,17 +57,6 @@ static bool consoleVisible = true;
 static WNDPROC originalConsoleProc = NULL;
 
 // -------- utilities --------
-static inline std::string trim(const std::string &s){
-    size_t a=0, b=s.size();
-    while(a<b && std::isspace((unsigned char)s[a])) ++a;
-    while(b>a && std::isspace((unsigned char)s[b-1])) --b;
-    return s.substr(a,b-a);
-}
-static inline std::string toLowerStr(std::string s){
-    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    return s;
-}
-
 static std::string findFileNearby(const std::string &name){
     std::ifstream f(name);
     if(f.good()){ f.close(); return name; }
@@ -163,459 +144,226 @@ static std::string LoadLastConfig(){
     return "";
 }
 
-// -------- KeyMapping.cfg loader --------
-static bool LoadKeyMap(const std::string &path){
-    std::ifstream in(path);
-    if(!in.is_open()) return false;
-    std::string line;
-    size_t lineno = 0;
-    while(std::getline(in,line)){
-        ++lineno;
-        size_t pos = line.find_first_of("#;");
-        std::string s = (pos==std::string::npos) ? line : line.substr(0,pos);
-        s = trim(s);
-        if(s.empty()) continue;
-        size_t eq = s.find('=');
-        if(eq==std::string::npos) continue;
-        std::string name = trim(s.substr(0,eq));
-        std::string rhs  = trim(s.substr(eq+1));
-        if(name.empty() || rhs.empty()) continue;
-        size_t sp = rhs.find_first_of(" \t");
-        std::string valtok = (sp==std::string::npos) ? rhs : rhs.substr(0,sp);
-        try{
-            int code = std::stoi(valtok,nullptr,0);
-            keyMap[toLowerStr(name)] = code;
-        }catch(...){
-            continue;
+// ---- Load a profile into the registry ----
+// Goes through the compiled .umc image next to the .ini when it is current. Replacing
+// the active profile switches the engine to the new copy.
+static bool LoadMacrosFile(const std::string &path){
+    Profile *p = new Profile();
+    std::vector<ParseError> errors;
+    if(LoadProfileCached<Win32MappedFile>(path, keyMap, *p, &errors) == CacheResult::FAILED){
+        delete p;
+        return false;
+    }
+    std::string name = path.substr(path.find_last_of("\\/") + 1);
+    for(const auto &e : errors) {
+        std::wcout << std::wstring(name.begin(), name.end()) << L":" << e.line << L":" << e.column << L": "
+                   << (e.warning ? L"warning: " : L"") << std::wstring(e.message.begin(), e.message.end()) << L"\n";
+    }
+    std::vector<std::string> missingTraces;
+    AttachTraces<Win32MappedFile>(*p, path.substr(0, path.size() - name.size()), &missingTraces);
+    for(const auto &t : missingTraces) {
+        std::wcout << std::wstring(name.begin(), name.end()) << L": cannot read trace "
+                   << std::wstring(t.begin(), t.end()) << L", its [Replay] does nothing\n";
+    }
+    if(rawInput) {
+        int blocking = 0;
+        for(uint8_t s : p->suppress) blocking += s != kSuppressNever;
+        if(blocking) {
+            std::wcout << std::wstring(name.begin(), name.end()) << L": " << blocking
+                       << L" trigger(s) normally blocked will also reach applications under Raw Input\n";
         }
     }
+    registry->Put(name, path, p);
     return true;
 }
 
-// -------- Resolve name -> numeric code --------
-static int ResolveKeyName(const std::string &name){
-    std::string n = toLowerStr(trim(name));
-    if(n.empty()) return -1;
-    auto it = keyMap.find(n);
-    if(it != keyMap.end()) return it->second;
-
-    if(n=="lmb" || n=="mouse1") return 253;
-    if(n=="rmb" || n=="mouse2") return 252;
-    if(n=="mmb" || n=="mouse3" || n=="mouse_middle") return 4;
-    if(n=="mouse4") return 5;
-    if(n=="mouse5") return 6;
-    if(n=="mousewheel_up") return 254;
-    if(n=="mousewheel_down") return 255;
-
-    if(n=="space") return VK_SPACE;
-    if(n=="shift") return VK_SHIFT;
-    if(n=="ctrl")  return VK_CONTROL;
-    if(n=="alt")   return VK_MENU;
-    if(n=="enter" || n=="return") return VK_RETURN;
-    if(n=="esc" || n=="escape") return VK_ESCAPE;
-    if(n=="tab") return VK_TAB;
-    if(n=="backspace") return VK_BACK;
-    if(n=="capslock") return VK_CAPITAL;
-
-    if(n.size()>=2 && n[0]=='f'){
-        try{
-            int fn = std::stoi(n.substr(1));
-            if(fn >= 1 && fn <= 24) return VK_F1 + (fn-1);
-        }catch(...){}
-    }
-
-    if(n.size()==1){
-        char c = n[0];
-        if(c>='a' && c<='z') return (int)std::toupper(c);
-        if(c>='0' && c<='9') return (int)c;
-    }
-
-    try { return std::stoi(n,nullptr,0); } catch(...) {}
-    return -1;
+// Makes a resident profile the tray selection; a pointer swap, nothing is read
+static void SelectProfile(size_t index){
+    currentIniPath = registry->Entries()[index].path;
+    registry->Activate(index);
 }
 
-// ---- Map config code to VK code ----
-static int MapConfigCodeToDetectVK(int cfg){
-    switch(cfg){
-        case 253: return VK_LBUTTON;
-        case 252: return VK_RBUTTON;
-        case 4:   return VK_MBUTTON;
-        case 5:   return VK_XBUTTON1;
-        case 6:   return VK_XBUTTON2;
-        case 254: return -1;
-        case 255: return -1;
-        default: return cfg;
-    }
+// Path of the profile the engine is running, which may be an application's own
+static std::string ActiveIniPath(){
+    size_t active = registry->Active();
+    return active == ProfileRegistry::npos ? currentIniPath : registry->Entries()[active].path;
 }
 
-// ---- Sending helpers ----
-static void SendDownByConfigCode(int cfg){
-    if(cfg == 253){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_LEFTDOWN; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 252){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_RIGHTDOWN; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 4){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_MIDDLEDOWN; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 5 || cfg == 6){ WORD which = (cfg==5)?XBUTTON1:XBUTTON2; INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_XDOWN; in.mi.mouseData = which; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 254){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_WHEEL; in.mi.mouseData = WHEEL_DELTA; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 255){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_WHEEL; in.mi.mouseData = -WHEEL_DELTA; SendInput(1,&in,sizeof(INPUT)); return; }
-
-    INPUT in = {}; in.type = INPUT_KEYBOARD; in.ki.wVk = (WORD)cfg; in.ki.dwFlags = 0; SendInput(1,&in,sizeof(INPUT));
-}
-static void SendUpByConfigCode(int cfg){
-    if(cfg == 253){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_LEFTUP; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 252){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_RIGHTUP; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 4){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_MIDDLEUP; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 5 || cfg == 6){ WORD which = (cfg==5)?XBUTTON1:XBUTTON2; INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_XUP; in.mi.mouseData = which; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 254 || cfg == 255){ return; }
-
-    INPUT in = {}; in.type = INPUT_KEYBOARD; in.ki.wVk = (WORD)cfg; in.ki.dwFlags = KEYEVENTF_KEYUP; SendInput(1,&in,sizeof(INPUT));
-}
-static void SendClickByConfigCode(int cfg){
-    if(cfg == 253){ INPUT in[2] = {}; in[0].type=INPUT_MOUSE; in[0].mi.dwFlags=MOUSEEVENTF_LEFTDOWN; in[1].type=INPUT_MOUSE; in[1].mi.dwFlags=MOUSEEVENTF_LEFTUP; SendInput(2,in,sizeof(INPUT)); return; }
-    if(cfg == 252){ INPUT in[2] = {}; in[0].type=INPUT_MOUSE; in[0].mi.dwFlags=MOUSEEVENTF_RIGHTDOWN; in[1].type=INPUT_MOUSE; in[1].mi.dwFlags=MOUSEEVENTF_RIGHTUP; SendInput(2,in,sizeof(INPUT)); return; }
-    if(cfg == 4){ INPUT in[2] = {}; in[0].type=INPUT_MOUSE; in[0].mi.dwFlags=MOUSEEVENTF_MIDDLEDOWN; in[1].type=INPUT_MOUSE; in[1].mi.dwFlags=MOUSEEVENTF_MIDDLEUP; SendInput(2,in,sizeof(INPUT)); return; }
-    if(cfg == 5 || cfg == 6){ WORD which = (cfg==5)?XBUTTON1:XBUTTON2; INPUT in[2] = {}; in[0].type=INPUT_MOUSE; in[0].mi.dwFlags=MOUSEEVENTF_XDOWN; in[0].mi.mouseData=which; in[1].type=INPUT_MOUSE; in[1].mi.dwFlags=MOUSEEVENTF_XUP; in[1].mi.mouseData=which; SendInput(2,in,sizeof(INPUT)); return; }
-    if(cfg == 254){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_WHEEL; in.mi.mouseData = WHEEL_DELTA; SendInput(1,&in,sizeof(INPUT)); return; }
-    if(cfg == 255){ INPUT in = {}; in.type = INPUT_MOUSE; in.mi.dwFlags = MOUSEEVENTF_WHEEL; in.mi.mouseData = -WHEEL_DELTA; SendInput(1,&in,sizeof(INPUT)); return; }
-
-    INPUT down = {}; down.type = INPUT_KEYBOARD; down.ki.wVk = (WORD)cfg; INPUT up = down; up.ki.dwFlags = KEYEVENTF_KEYUP; SendInput(1,&down,sizeof(INPUT)); Sleep(1); SendInput(1,&up,sizeof(INPUT));
+// ---- Per-application switching ----
+// Runs on every foreground change: the profile that declares the application, else the
+// tray selection. Both are resident, so this is a table lookup and a pointer swap.
+static void OnForegroundChanged(const std::string &exe, const std::string &windowClass){
+    size_t index = registry->Match(exe, windowClass);
+    if(index == ProfileRegistry::npos && !currentIniPath.empty()){
+        index = registry->Find(currentIniPath.substr(currentIniPath.find_last_of("\\/") + 1));
+    }
+    if(index == ProfileRegistry::npos || index == registry->Active()) return;
+    registry->Activate(index);
+    const std::string &name = registry->Entries()[index].name;
+    std::wcout << L"Switched to " << std::wstring(name.begin(), name.end()) << L" for "
+               << std::wstring(exe.begin(), exe.end()) << L"\n";
 }
 
-// ---- Parse a macro line ----
-static bool ParseMacroLine(const std::string &line,
-                           std::string &actionOut, std::string &modeOut,
-                           bool &keepOut, bool &dropOut,
-                           std::string &triggerOut, std::string &targetOut,
-                           float &intervalOut)
-{
-    size_t i=0, n=line.size();
-    auto skip=[&](){ while(i<n && std::isspace((unsigned char)line[i])) ++i; };
-    skip();
-    if(!(i<n && line[i]=='[')){
-        return false;
-    }
-    ++i; size_t actionStart=i;
-    while(i<n && line[i]!=']') ++i;
-    if(i>=n){
-        return false;
-    }
-    actionOut = trim(line.substr(actionStart, i-actionStart));
-    ++i; skip();
-
-    modeOut = "";
-    bool isBind = (toLowerStr(actionOut) == "bind");
-    if(!isBind && i<n && line[i]=='['){
-        ++i; size_t modeStart=i;
-        while(i<n && line[i]!=']') ++i;
-        if(i>=n){
-            return false;
-        }
-        modeOut = trim(line.substr(modeStart, i-modeStart));
-        ++i; skip();
-    }
-
-    keepOut = false; dropOut = false;
-    if(i<n && line[i]=='['){
-        ++i; size_t flagStart=i;
-        while(i<n && line[i]!=']') ++i;
-        if(i>=n){
-            return false;
-        }
-        std::string tag = trim(line.substr(flagStart, i-flagStart));
-        std::string tagLower = toLowerStr(tag);
-        if(tagLower == "k" || tagLower == "keep"){
-            keepOut = true;
-        } else if(tagLower == "d" || tagLower == "drop"){
-            dropOut = true;
+// Makes every profile in the CFG folder resident. After this only folder changes
+// (WM_CFG_CHANGED) and an explicit refresh read profiles from disk.
+static void LoadAllProfiles(){
+    std::vector<std::string> files;
+    FindIniFiles(files);
+    for(const auto &file : files){
+        if(registry->Find(file) != ProfileRegistry::npos) continue;
+        if(!LoadMacrosFile(cfgFolder + file)) {
+            std::wcout << L"Failed to load config: " << std::wstring(file.begin(), file.end()) << L"\n";
         }
-        ++i; skip();
-    }
-
-    if(!(i<n && line[i]=='\"')){
-        return false;
-    }
-    ++i; size_t triggerStart=i;
-    while(i<n && line[i]!='\"') ++i;
-    if(i>=n){
-        return false;
-    }
-    triggerOut = trim(line.substr(triggerStart, i-triggerStart));
-    ++i; skip();
-    if(!(i<n && line[i]=='\"')){
-        return false;
-    }
-    ++i; size_t targetStart=i;
-    while(i<n && line[i]!='\"') ++i;
-    if(i>=n){
-        return false;
     }
-    targetOut = trim(line.substr(targetStart, i-targetStart));
-    ++i; skip();
-    intervalOut = 0.0f;
-    if(i<n && line[i]=='['){
-        ++i; size_t intervalStart=i;
-        while(i<n && line[i]!=']') ++i;
-        if(i>=n){
-            return false;
-        }
-        std::string istr = trim(line.substr(intervalStart,i-intervalStart));
-        try {
-            float v = std::stof(istr);
-            if(v<=0){
-                return false;
-            }
-            intervalOut = v;
-        } catch(...) {
-            return false;
+    for(const auto &e : registry->Entries()) {
+        for(const auto &app : e.profile->apps) {
+            std::wcout << std::wstring(e.name.begin(), e.name.end()) << L" follows "
+                       << (app.kind == AppMatch::EXE ? L"" : L"window class ")
+                       << std::wstring(app.name.begin(), app.name.end()) << L"\n";
         }
     }
-    return true;
 }
 
-// ---- Function prototype for MacroTimerProc ----
-void CALLBACK MacroTimerProc(UINT, UINT, DWORD_PTR, DWORD_PTR, DWORD_PTR);
-
-// ---- Load macros file ----
-static bool LoadMacrosFile(const std::string &path){
-    std::ifstream in(path);
-    if(!in.is_open()){
-        return false;
-    }
-    std::string line;
-    size_t lineno=0;
-    std::vector<Macro*> newMacros;
-    while(std::getline(in,line)){
-        ++lineno;
-        std::string s=line;
-        size_t cpos = s.find_first_of("#;");
-        if(cpos!=std::string::npos) s = s.substr(0,cpos);
-        s = trim(s);
-        if(s.empty()) continue;
-        std::string action, mode, trgName, tgtName;
-        bool keep=false, drop=false;
-        float interval = 0.0f;
-        if(!ParseMacroLine(s, action, mode, keep, drop, trgName, tgtName, interval)){
+// ---- --compile / --check ----
+// Validates every .ini in the CFG folder in one pass. --compile also (re)writes each
+// compiled image; --check only reports whether it is current. Returns the exit code.
+static int CompileAllProfiles(const std::string &cfgFolder, bool write){
+    std::vector<std::string> files;
+    FindIniFiles(files);
+    int failures = 0;
+    for(const auto &file : files){
+        std::string path = cfgFolder + file;
+        // Stamped before the read, so an edit in between leaves the image to be rehashed
+        uint64_t stamp = ProfileSourceStamp(path, keyMap);
+        std::ifstream in(path, std::ios::binary);
+        if(!in.is_open()){
+            std::wcout << std::wstring(file.begin(), file.end()) << L": cannot open\n";
+            ++failures;
             continue;
         }
-        std::string trgNameN = toLowerStr(trim(trgName));
-        std::string tgtNameN = toLowerStr(trim(tgtName));
-
-        int trg = ResolveKeyName(trgNameN);
-        int tgt = ResolveKeyName(tgtNameN);
-        if(trg == -1 || tgt == -1){
-            continue;
+        std::ostringstream text;
+        text << in.rdbuf();
+        std::string source = text.str();
+        uint64_t hash = ProfileSourceHash(source, keyMap);
+
+        Profile parsed;
+        std::vector<ParseError> errors;
+        size_t skipped = ParseMacros(source, keyMap, parsed, &errors);
+        if(skipped) ++failures;
+        for(const auto &e : errors) {
+            std::wcout << std::wstring(file.begin(), file.end()) << L":" << e.line << L":" << e.column << L": "
+                       << (e.warning ? L"warning: " : L"") << std::wstring(e.message.begin(), e.message.end()) << L"\n";
         }
-        Macro *m = new Macro();
-        m->triggerCfg = static_cast<DWORD>(trg);
-        m->targetCfg  = static_cast<DWORD>(tgt);
-        m->clickHold = true;
-        if(toLowerStr(action)=="autoclick"){
-            m->keepOriginal = keep;
-            m->dropOriginal = drop;
-            m->bindKeepOriginal = keep;
-            m->bindDropOriginal = drop;
-            m->action = Macro::ACTION_AUTOCLICK;
-            if(toLowerStr(mode)=="toggle") m->clickHold = false;
-            if(interval==0){
-                delete m;
-                continue;
-            }
-            m->originalIntervalMs = interval;
-            if(interval < 1.0f){
-                m->clicksPerTick = static_cast<int>(std::ceil(1.0f / interval));
-                m->effectiveIntervalMs = 1.0f;
-            } else {
-                m->clicksPerTick = 1;
-                m->effectiveIntervalMs = interval;
-            }
-            m->active.store(false);
-        } else if(toLowerStr(action)=="bind"){
-            m->action = Macro::ACTION_BIND;
-            m->keepOriginal = keep;
-            m->dropOriginal = drop;
-            m->bindKeepOriginal = keep;
-            m->bindDropOriginal = drop;
-            m->originalIntervalMs = 0.0f;
-            m->effectiveIntervalMs = 0.0f;
-            m->clicksPerTick = 0;
-            m->active.store(false);
-            m->bindTargetDown.store(false);
-        } else {
-            delete m;
-            continue;
+
+        // A current image must decode to exactly what the text parses to
+        const wchar_t *status = L"missing";
+        Win32MappedFile image;
+        if(image.Open(CompiledProfilePath(path))){
+            Profile cached;
+            std::vector<ParseError> cachedErrors;
+            if(!LoadCompiledProfile(image.Data(), image.Size(), hash, cached, &cachedErrors)) status = L"stale";
+            else if(CompileProfile(cached, hash, 0, &cachedErrors) != CompileProfile(parsed, hash, 0, &errors)) status = L"corrupt";
+            else status = L"current";
         }
-        newMacros.push_back(m);
-    }
-    in.close();
-    
-    // Cleanup old macros
-    for(auto m : macros){
-        if(m->timerId) timeKillEvent(m->timerId);
-        delete m;
-    }
-    macros.clear();
-    
-    // Assign new macros and set up timers
-    macros = newMacros;
-    for(auto m : macros){
-        if(m->action == Macro::ACTION_AUTOCLICK && m->effectiveIntervalMs > 0){
-            m->timerId = timeSetEvent(static_cast<UINT>(m->effectiveIntervalMs), 1, MacroTimerProc, (DWORD_PTR)m, TIME_PERIODIC | TIME_CALLBACK_FUNCTION);
+        image.Close();
+        if(write){
+            status = WriteCompiledProfile(CompiledProfilePath(path), parsed, hash, stamp, &errors) ? L"written" : L"write failed";
         }
+        std::wcout << std::wstring(file.begin(), file.end()) << L": " << parsed.macros.size() << L" macros, "
+                   << skipped << L" invalid lines, image " << status << L"\n";
     }
-    
-    return true;
+    std::wcout << files.size() << L" profiles, " << failures << L" with errors\n";
+    return failures ? 1 : 0;
 }
 
-// ---- Timer callback ----
-void CALLBACK MacroTimerProc(UINT, UINT, DWORD_PTR dwUser, DWORD_PTR, DWORD_PTR){
-    Macro *m = reinterpret_cast<Macro*>(dwUser);
-    if(!m) return;
-    if(isPaused.load()) return;
-    if(m->action != Macro::ACTION_AUTOCLICK) return;
-    if(m->active.load()){
-        for(int i = 0; i < m->clicksPerTick; ++i){
-            SendClickByConfigCode((int)m->targetCfg);
+static std::wstring PolicyText(const ThreadPolicy &policy){
+    static const wchar_t *kPriorities[] = { L"normal", L"high", L"realtime" };
+    std::wstring text = kPriorities[policy.priority];
+    if(policy.cores) {
+        text += L" on cores";
+        for(int c = 0; c < 64; ++c) {
+            if(policy.cores >> c & 1) text += L" " + std::to_wstring(c);
         }
     }
+    return text;
 }
 
-// ---- Low-level hooks ----
-static HHOOK gKeyboardHook = nullptr;
-static HHOOK gMouseHook = nullptr;
-
-static inline bool ShouldSuppressOriginal(const Macro* m){
-    if(m->keepOriginal) return false;
-    if(m->dropOriginal) return true;
-    return true;
-}
-
-LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam){
-    if(nCode < HC_ACTION) return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
-    auto info = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
-    if(!info) return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
-    if((info->flags & LLKHF_INJECTED) != 0) return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
-
-    bool isDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
-    int vk = (int)info->vkCode;
-
-    if(vk == '8') key8Down = isDown;
-    if(vk == '9') key9Down = isDown;
-    if(vk == '0') key0Down = isDown;
-
-    if(key8Down && key9Down && key0Down){
-        ULONGLONG now = GetTickCount64();
-        if(now - lastPauseToggle > DEBOUNCE_MS){
-            bool wasPaused = isPaused.load();
-            isPaused.store(!wasPaused);
-            lastPauseToggle = now;
-            if(isPaused.load()){
-                for(auto m : macros){
-                    if(m->action == Macro::ACTION_AUTOCLICK){
-                        m->active.store(false);
-                    }
-                }
-                std::wcout << L"Macros paused\n";
-            } else {
-                std::wcout << L"Macros resumed\n";
-            }
-            return 1;
+static void PrintMacros(){
+    const Profile *profile = engine->GetProfile();
+    if(!profile) return;
+    if(profile->injectPolicy != ThreadPolicy() || profile->capturePolicy != ThreadPolicy()) {
+        std::wcout << L"Threads: inject " << PolicyText(profile->injectPolicy)
+                   << L", capture " << PolicyText(profile->capturePolicy) << L"\n";
+    }
+    if(profile->injectBudget) std::wcout << L"Budget: " << profile->injectBudget << L" events/s\n";
+    for (size_t i = 0; i < profile->macros.size(); ++i) {
+        auto m = profile->macros[i];
+        std::string mode = m->action == Macro::ACTION_BIND
+            ? (m->keepOriginal ? "K" : (m->dropOriginal ? "D" : "Default"))
+            : (m->runOnce ? "ONCE" : m->clickHold ? "HOLD" : "TOGGLE");
+        std::string action = ActionName(m->action);
+        std::wcout << L"#" << (i + 1)
+                  << L": action=" << std::wstring(action.begin(), action.end())
+                  << L" mode=" << std::wstring(mode.begin(), mode.end())
+                  << L" triggerCfg=" << m->triggerCfg
+                  << L" targetCfg=" << m->targetCfg
+                  << L" intervalMs=" << m->originalIntervalMs;
+        if(m->action == Macro::ACTION_AUTOCLICK && m->periodNs > 0){
+            std::wcout << L" (" << 1e9 / static_cast<double>(m->periodNs) << L" CPS)";
         }
-    }
-
-    if(isPaused.load()) return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
-
-    bool handled = false;
-    for(auto m : macros){
-        int detect = MapConfigCodeToDetectVK((int)m->triggerCfg);
-        if(detect <= 0) continue;
-        if(detect != vk) continue;
-
-        bool suppress = ShouldSuppressOriginal(m);
-        if(m->action == Macro::ACTION_AUTOCLICK){
-            if(m->clickHold){
-                m->active.store(isDown);
-            } else {
-                if(isDown){ m->active.store(!m->active.load()); }
-            }
-            handled = handled || suppress;
-        } else if(m->action == Macro::ACTION_BIND){
-            if(isDown){
-                if(!m->bindTargetDown.load()){
-                    SendDownByConfigCode((int)m->targetCfg);
-                    m->bindTargetDown.store(true);
-                }
-            } else {
-                if(m->bindTargetDown.load()){
-                    SendUpByConfigCode((int)m->targetCfg);
-                    m->bindTargetDown.store(false);
-                }
-            }
-            handled = handled || suppress;
+        if(m->wheelMode != Macro::WHEEL_EACH) std::wcout << (m->wheelMode == Macro::WHEEL_SMOOTH ? L" wheel=smooth" : L" wheel=coalesce");
+        if(m->action == Macro::ACTION_SEQUENCE) std::wcout << L" steps=" << m->sequenceLength;
+        if(m->action == Macro::ACTION_REPLAY) {
+            std::wcout << L" trace=" << std::wstring(m->traceFile.begin(), m->traceFile.end());
+            if(m->trace) std::wcout << L" events=" << m->trace->count << L" (" << m->trace->DurationNs() / 1e9 << L" s)";
+            else std::wcout << L" (not loaded)";
         }
+        std::wcout << L"\n";
     }
-
-    if(handled) return 1;
-    return CallNextHookEx(gKeyboardHook,nCode,wParam,lParam);
 }
 
-LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam){
-    if(nCode < HC_ACTION) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
-    auto info = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
-    if(!info) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
-    if((info->flags & LLMHF_INJECTED) != 0) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
-
-    if(isPaused.load()) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
-
-    bool isDown = false;
-    int evVK = -1;
-    switch(wParam){
-        case WM_LBUTTONDOWN: isDown = true; evVK = VK_LBUTTON; break;
-        case WM_LBUTTONUP:   isDown = false; evVK = VK_LBUTTON; break;
-        case WM_RBUTTONDOWN: isDown = true; evVK = VK_RBUTTON; break;
-        case WM_RBUTTONUP:   isDown = false; evVK = VK_RBUTTON; break;
-        case WM_MBUTTONDOWN: isDown = true; evVK = VK_MBUTTON; break;
-        case WM_MBUTTONUP:   isDown = false; evVK = VK_MBUTTON; break;
-        case WM_XBUTTONDOWN:
-        case WM_XBUTTONUP: {
-            WORD hi = HIWORD(info->mouseData);
-            if(hi == XBUTTON1) evVK = VK_XBUTTON1;
-            else if(hi == XBUTTON2) evVK = VK_XBUTTON2;
-            isDown = (wParam == WM_XBUTTONDOWN);
-            break;
-        }
-        default:
-            break;
+// ---- Input recording ----
+// Traces go next to the profiles, where a [Replay] finds them by file name
+static void ToggleRecording(){
+    if(recorder->Recording()) {
+        recorder->Stop();
+        std::wcout << L"Recording stopped: " << recorder->recorded.load() << L" events, "
+                   << recorder->dropped.load() << L" dropped" << (recorder->WriteFailed() ? L", write failed" : L"") << L"\n";
+        return;
+    }
+    SYSTEMTIME now;
+    GetLocalTime(&now);
+    char name[64];
+    snprintf(name, sizeof(name), "record-%04d%02d%02d-%02d%02d%02d.umt", now.wYear, now.wMonth, now.wDay,
+             now.wHour, now.wMinute, now.wSecond);
+    std::string path = cfgFolder + name;
+    if(recorder->Start(path, sysClock->NowNs())) {
+        std::wcout << L"Recording input to " << std::wstring(path.begin(), path.end()) << L"\n";
+    } else {
+        std::wcout << L"Cannot record to " << std::wstring(path.begin(), path.end()) << L"\n";
     }
+}
 
-    if(evVK == -1) return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
-
-    bool handled = false;
-    for(auto m : macros){
-        int detect = MapConfigCodeToDetectVK((int)m->triggerCfg);
-        if(detect <= 0) continue;
-        if(detect != evVK) continue;
-
-        bool suppress = ShouldSuppressOriginal(m);
-        if(m->action == Macro::ACTION_AUTOCLICK){
-            if(m->clickHold){ m->active.store(isDown); }
-            else { if(isDown) m->active.store(!m->active.load()); }
-            handled = handled || suppress;
-        } else if(m->action == Macro::ACTION_BIND){
-            if(isDown){
-                if(!m->bindTargetDown.load()){
-                    SendDownByConfigCode((int)m->targetCfg);
-                    m->bindTargetDown.store(true);
-                }
-            } else {
-                if(m->bindTargetDown.load()){
-                    SendUpByConfigCode((int)m->targetCfg);
-                    m->bindTargetDown.store(false);
-                }
-            }
-            handled = handled || suppress;
-        }
-    }
+// ---- Stats ----
+static void PrintStats(){
+    std::ostringstream table;
+    WriteStatsTable(*engine, table);
+    std::string text = table.str();
+    std::wcout << L"---- Stats ----\n" << std::wstring(text.begin(), text.end());
+}
 
-    if(handled) return 1;
-    return CallNextHookEx(gMouseHook,nCode,wParam,lParam);
+// Writes CFG\stats.csv next to the executable and returns its path ("" on failure)
+static std::string ExportStatsCsv(){
+    TCHAR path[MAX_PATH];
+    if(GetModuleFileName(NULL, path, MAX_PATH) == 0) return "";
+    std::wstring full(path);
+    size_t p = full.find_last_of(L"\\/");
+    if(p == std::wstring::npos) return "";
+    std::string csvPath = std::string(full.begin(), full.begin() + p + 1) + "CFG\\stats.csv";
+    std::ofstream out(csvPath);
+    if(!out.is_open()) return "";
+    WriteStatsCsv(*engine, out);
+    return csvPath;
 }
 
 // ---- Tray functions ----
@@ -629,22 +377,34 @@ static void ShowConsole(bool show) {
     consoleVisible = show;
 }
 
-// ---- Build tray menu with dynamic .ini files submenu ----
+// ---- Build tray menu with the resident profiles submenu ----
+// Built from the registry, so opening the menu never scans the CFG folder
 static void BuildTrayMenu() {
     if(hMenu) DestroyMenu(hMenu);
     hMenu = CreatePopupMenu();
     
-    // Add "Switch Config" submenu
+    // Add "Switch Config" submenu: name, macro count, and a check on the running profile
     HMENU hSubMenu = CreatePopupMenu();
-    FindIniFiles(iniFiles);
-    for(size_t i = 0; i < iniFiles.size(); ++i) {
-        std::wstring wFileName(iniFiles[i].begin(), iniFiles[i].end());
-        AppendMenuW(hSubMenu, MF_STRING, ID_TRAY_INI_BASE + i, wFileName.c_str());
+    const auto &entries = registry->Entries();
+    for(size_t i = 0; i < entries.size(); ++i) {
+        std::wstring label(entries[i].name.begin(), entries[i].name.end());
+        label += L"\t" + std::to_wstring(entries[i].profile->macros.size());
+        UINT flags = MF_STRING | (i == registry->Active() ? MF_CHECKED : MF_UNCHECKED);
+        AppendMenuW(hSubMenu, flags, ID_TRAY_INI_BASE + i, label.c_str());
     }
     AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hSubMenu, L"\u0412\u044b\u0431\u0440\u0430\u0442\u044c \u043a\u043e\u043d\u0444\u0438\u0433");
 
     // Add Start/Stop toggle
-    AppendMenuW(hMenu, MF_STRING, ID_TRAY_TOGGLE, isPaused.load() ? L"\u0421\u0442\u0430\u0440\u0442" : L"\u0421\u0442\u043e\u043f");
+    AppendMenuW(hMenu, MF_STRING, ID_TRAY_TOGGLE, engine->IsPaused() ? L"\u0421\u0442\u0430\u0440\u0442" : L"\u0421\u0442\u043e\u043f");
+
+    // Add stats items
+    AppendMenuW(hMenu, MF_STRING, ID_TRAY_STATS, L"\u0421\u0442\u0430\u0442\u0438\u0441\u0442\u0438\u043a\u0430");
+    AppendMenuW(hMenu, MF_STRING, ID_TRAY_STATS_CSV, L"\u0421\u0442\u0430\u0442\u0438\u0441\u0442\u0438\u043a\u0430 \u0432 CSV");
+
+    // Add input recording toggle
+    AppendMenuW(hMenu, MF_STRING, ID_TRAY_RECORD, recorder->Recording()
+        ? L"\u041e\u0441\u0442\u0430\u043d\u043e\u0432\u0438\u0442\u044c \u0437\u0430\u043f\u0438\u0441\u044c"
+        : L"\u0417\u0430\u043f\u0438\u0441\u044c \u0432\u0432\u043e\u0434\u0430");
 
     // Add other menu items
     AppendMenuW(hMenu, MF_STRING, ID_TRAY_REFRESH, L"\u041e\u0431\u043d\u043e\u0432\u0438\u0442\u044c \u043c\u0430\u043a\u0440\u043e\u0441");
@@ -691,102 +451,86 @@ LRESULT CALLBACK TrayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     case WM_COMMAND:
         switch (LOWORD(wParam)) {
         case ID_TRAY_TOGGLE:
-            {
-                bool wasPaused = isPaused.load();
-                isPaused.store(!wasPaused);
-                if(isPaused.load()) {
-                    for(auto m : macros){
-                        if(m->action == Macro::ACTION_AUTOCLICK){
-                            m->active.store(false);
-                        }
-                    }
-                    std::wcout << L"Macros paused\n";
-                } else {
-                    std::wcout << L"Macros resumed\n";
-                }
+            engine->SetPaused(!engine->IsPaused());
+            break;
+        case ID_TRAY_STATS:
+            PrintStats();
+            ShowConsole(true);
+            break;
+        case ID_TRAY_RECORD:
+            ToggleRecording();
+            break;
+        case ID_TRAY_STATS_CSV: {
+            std::string csvPath = ExportStatsCsv();
+            if(!csvPath.empty()) {
+                std::wcout << L"Stats written to " << std::wstring(csvPath.begin(), csvPath.end()) << L"\n";
+            } else {
+                std::wcout << L"Failed to write stats CSV\n";
             }
             break;
-        case ID_TRAY_REFRESH:
-            if(!currentIniPath.empty()) {
+        }
+        case ID_TRAY_REFRESH: {
+            std::string activePath = ActiveIniPath();
+            if(!activePath.empty()) {
                 system("cls"); // Clear console
-                if(LoadMacrosFile(currentIniPath)) {
-                    SaveLastConfig(currentIniPath.substr(currentIniPath.find_last_of("\\/") + 1));
-                    std::wcout << L"Macros reloaded: " << macros.size() << L"\n";
-                    for (size_t i = 0; i < macros.size(); ++i) {
-                        auto m = macros[i];
-                        std::string mode = m->action == Macro::ACTION_AUTOCLICK
-                            ? (m->clickHold ? "HOLD" : "TOGGLE")
-                            : (m->keepOriginal ? "K" : (m->dropOriginal ? "D" : "Default"));
-                        std::wcout << L"#" << (i + 1)
-                                  << L": action=" << (m->action == Macro::ACTION_AUTOCLICK ? L"AutoClick" : L"Bind")
-                                  << L" mode=" << std::wstring(mode.begin(), mode.end())
-                                  << L" triggerCfg=" << m->triggerCfg
-                                  << L" targetCfg=" << m->targetCfg
-                                  << L" intervalMs=" << m->originalIntervalMs;
-                        if(m->action == Macro::ACTION_AUTOCLICK && m->originalIntervalMs > 0){
-                            int cps = static_cast<int>(std::round(1000.0f / m->originalIntervalMs));
-                            std::wcout << L"(-" << cps << L"CPS)";
-                        }
-                        std::wcout << L"\n";
-                    }
+                if(LoadMacrosFile(activePath)) {
+                    std::wcout << L"Macros reloaded: " << engine->MacroCount() << L"\n";
+                    PrintMacros();
                 } else {
-                    std::wcout << L"Failed to reload macros from " << std::wstring(currentIniPath.begin(), currentIniPath.end()) << L"\n";
+                    std::wcout << L"Failed to reload macros from " << std::wstring(activePath.begin(), activePath.end()) << L"\n";
                 }
             }
             break;
-        case ID_TRAY_EDIT:
-            if(!currentIniPath.empty()) {
-                ShellExecuteA(NULL, "open", currentIniPath.c_str(), NULL, NULL, SW_SHOWNORMAL);
+        }
+        case ID_TRAY_EDIT: {
+            std::string activePath = ActiveIniPath();
+            if(!activePath.empty()) {
+                ShellExecuteA(NULL, "open", activePath.c_str(), NULL, NULL, SW_SHOWNORMAL);
             }
             break;
+        }
         case ID_TRAY_EXIT:
             PostQuitMessage(0);
             break;
         default:
             // Handle .ini file selection
-            if(LOWORD(wParam) >= ID_TRAY_INI_BASE && LOWORD(wParam) < ID_TRAY_INI_BASE + iniFiles.size()) {
+            if(LOWORD(wParam) >= ID_TRAY_INI_BASE && LOWORD(wParam) < ID_TRAY_INI_BASE + registry->Entries().size()) {
                 size_t index = LOWORD(wParam) - ID_TRAY_INI_BASE;
-                if(index < iniFiles.size()) {
-                    TCHAR path[MAX_PATH];
-                    if(GetModuleFileName(NULL, path, MAX_PATH) > 0) {
-                        std::wstring full(path);
-                        size_t p = full.find_last_of(L"\\/");
-                        if(p != std::wstring::npos) {
-                            std::wstring folder = full.substr(0, p+1);
-                            currentIniPath = std::string(folder.begin(), folder.end()) + "CFG\\" + iniFiles[index];
-                            system("cls"); // Clear console
-                            if(LoadMacrosFile(currentIniPath)) {
-                                SaveLastConfig(iniFiles[index]);
-                                std::wcout << L"Switched to config: " << std::wstring(iniFiles[index].begin(), iniFiles[index].end()) << L"\n";
-                                std::wcout << L"Macros loaded: " << macros.size() << L"\n";
-                                for (size_t i = 0; i < macros.size(); ++i) {
-                                    auto m = macros[i];
-                                    std::string mode = m->action == Macro::ACTION_AUTOCLICK
-                                        ? (m->clickHold ? "HOLD" : "TOGGLE")
-                                        : (m->keepOriginal ? "K" : (m->dropOriginal ? "D" : "Default"));
-                                    std::wcout << L"#" << (i + 1)
-                                              << L": action=" << (m->action == Macro::ACTION_AUTOCLICK ? L"AutoClick" : L"Bind")
-                                              << L" mode=" << std::wstring(mode.begin(), mode.end())
-                                              << L" triggerCfg=" << m->triggerCfg
-                                              << L" targetCfg=" << m->targetCfg
-                                              << L" intervalMs=" << m->originalIntervalMs;
-                                    if(m->action == Macro::ACTION_AUTOCLICK && m->originalIntervalMs > 0){
-                                        int cps = static_cast<int>(std::round(1000.0f / m->originalIntervalMs));
-                                        std::wcout << L"(-" << cps << L"CPS)";
-                                    }
-                                    std::wcout << L"\n";
-                                }
-                            } else {
-                                std::wcout << L"Failed to load config: " << std::wstring(iniFiles[index].begin(), iniFiles[index].end()) << L"\n";
-                            }
-                        }
-                    }
-                }
+                const std::string &name = registry->Entries()[index].name;
+                system("cls"); // Clear console
+                SelectProfile(index);
+                std::wcout << L"Switched to config: " << std::wstring(name.begin(), name.end()) << L"\n";
+                std::wcout << L"Macros loaded: " << engine->MacroCount() << L"\n";
+                PrintMacros();
             }
             break;
         }
         break;
 
+    case WM_CFG_CHANGED: {
+        // Posted by the CFG folder watcher with the changed file's name. The registry
+        // follows the folder: edited profiles are reloaded, new ones added, deleted ones dropped.
+        std::string *file = reinterpret_cast<std::string*>(lParam);
+        size_t dot = file->find_last_of('.');
+        if(dot != std::string::npos && _stricmp(file->c_str() + dot, ".ini") == 0) {
+            std::wstring wname(file->begin(), file->end());
+            std::string path = cfgFolder + *file;
+            bool known = registry->Find(*file) != ProfileRegistry::npos;
+            if(GetFileAttributesA(path.c_str()) == INVALID_FILE_ATTRIBUTES) {
+                if(known) {
+                    registry->Remove(*file);
+                    std::wcout << L"Config removed: " << wname << L"\n";
+                }
+            } else if(LoadMacrosFile(path)) {
+                std::wcout << (known ? L"Config changed on disk, reloaded: " : L"Config added: ") << wname << L"\n";
+            } else {
+                std::wcout << L"Failed to reload changed config: " << wname << L"\n";
+            }
+        }
+        delete file;
+        break;
+    }
+
     case WM_DESTROY:
         PostQuitMessage(0);
         break;
@@ -796,87 +540,137 @@ LRESULT CALLBACK TrayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 // ---- Cleanup helper ----
 static void CleanupAll(){
-    for(auto m : macros){ if(m->timerId) timeKillEvent(m->timerId); }
-    if(gKeyboardHook) { UnhookWindowsHookEx(gKeyboardHook); gKeyboardHook = nullptr; }
-    if(gMouseHook)    { UnhookWindowsHookEx(gMouseHook);    gMouseHook = nullptr; }
-    timeEndPeriod(1);
-    for(auto m : macros) delete m;
-    macros.clear();
+    // Saved once here rather than on every switch, which stays free of disk writes
+    if(!currentIniPath.empty()) SaveLastConfig(currentIniPath.substr(currentIniPath.find_last_of("\\/") + 1));
+    cfgWatcher.Stop();
+    // Change notices posted but never dispatched still own their file name
+    MSG pending;
+    while(hwndTray && PeekMessage(&pending, hwndTray, WM_CFG_CHANGED, WM_CFG_CHANGED, PM_REMOVE))
+        delete reinterpret_cast<std::string*>(pending.lParam);
+    focusWatcher.Stop();
+    if(capture) capture->Stop();
+    if(recorder) recorder->Stop();
+    delete registry;
+    registry = nullptr;
+    delete recorder;
+    recorder = nullptr;
+    delete engine;
+    engine = nullptr;
+    delete capture;
+    capture = nullptr;
+    delete sysClock;
+    sysClock = nullptr;
     Shell_NotifyIcon(NIM_DELETE, &nid);
     DestroyMenu(hMenu);
     if (hwndTray) DestroyWindow(hwndTray);
     if (originalConsoleProc) SetWindowLongPtr(hwndConsole, GWLP_WNDPROC, (LONG_PTR)originalConsoleProc);
 }
 
+static int Usage(){
+    std::wcout << L"usage: unimacro [--compile | --check] [--rawinput [--device NAME]...] [ini]\n";
+    return 2;
+}
+
 int main(int argc, char** argv){
     AllocConsole();
     hwndConsole = GetConsoleWindow();
     std::wcout << L"UniMacro engine starting...\n";
-    std::wcout << L"8+9+0 to pause/resume\n";
+    std::wcout << L"8+9+0 to pause/resume, unless the profile sets its own [Pause] chord\n";
+
+    // [ini] [--rawinput [--device NAME]...]: Raw Input capture, optionally limited to the
+    // devices whose interface name contains one of the NAMEs, instead of the hooks
+    // --compile / --check: (re)build or just verify the CFG\*.umc caches, then exit
+    std::string iniArg;
+    std::vector<std::string> rawDevices;
+    bool compileAll = false, checkAll = false;
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if(arg == "--rawinput") rawInput = true;
+        else if(arg == "--device" && i + 1 < argc) rawDevices.push_back(argv[++i]);
+        else if(arg == "--compile") compileAll = true;
+        else if(arg == "--check") checkAll = true;
+        else if(arg[0] == '-') return Usage();
+        else if(iniArg.empty()) iniArg = arg;
+        else return Usage();
+    }
+    if((compileAll && checkAll) || (!rawDevices.empty() && !rawInput)) return Usage();
+
+    sysClock = new Win32Clock();
+    if(rawInput) {
+        Win32RawInputSource *raw = new Win32RawInputSource(*sysClock);
+        raw->devices = rawDevices;
+        capture = raw;
+        std::wcout << L"Capturing through Raw Input: triggers are seen but never blocked\n";
+    } else {
+        capture = new Win32HookSource(*sysClock);
+    }
+    engine = new Engine(injector, *sysClock);
+    engine->threadTuner = &threadTuner;
+    engine->onPauseChanged = [](bool paused){
+        std::wcout << (paused ? L"Macros paused" : L"Macros resumed")
+                   << L" (hook p50 " << engine->hookResidency.Percentile(0.50) / 1000.0
+                   << L" us, p99 " << engine->hookResidency.Percentile(0.99) / 1000.0 << L" us)\n";
+    };
+    engine->onProfileAdopted = [](const Engine::ReloadDiff &diff){
+        std::wcout << L"Profile applied: " << diff.kept << L" unchanged, " << diff.added
+                   << L" added, " << diff.removed << L" removed\n";
+    };
+    registry = new ProfileRegistry(*engine);
+    recorder = new TraceRecorder(*engine);
 
     std::string keymapName = "KeyMapping.cfg";
     std::string keymapPath = findFileNearby(keymapName);
     if(!keymapPath.empty()){
-        if(LoadKeyMap(keymapPath)){
+        if(keyMap.Load(keymapPath)){
             std::wcout << L"Loaded KeyMapping from: " << std::wstring(keymapPath.begin(), keymapPath.end()) << L"\n";
         }
     }
 
+    TCHAR exePath[MAX_PATH];
+    if(GetModuleFileName(NULL, exePath, MAX_PATH) > 0) {
+        std::wstring full(exePath);
+        size_t p = full.find_last_of(L"\\/");
+        if(p != std::wstring::npos) cfgFolder = std::string(full.begin(), full.begin() + p + 1) + "CFG\\";
+    }
+
+    if(compileAll || checkAll) {
+        int code = CompileAllProfiles(cfgFolder, compileAll);
+        CleanupAll();
+        return code;
+    }
+
     // Try to load last used config
     std::string iniName = LoadLastConfig();
-    if(iniName.empty() && argc >= 2) {
-        iniName = argv[1]; // Use command-line argument if provided
+    if(iniName.empty() && !iniArg.empty()) {
+        iniName = iniArg; // Use command-line argument if provided
     }
 
-    // Find all .ini files
-    FindIniFiles(iniFiles);
-    if(!iniFiles.empty()) {
-        std::wcout << L"Available config files: " << iniFiles.size() << L"\n";
-        for(const auto& file : iniFiles) {
-            std::wcout << L" - " << std::wstring(file.begin(), file.end()) << L"\n";
+    // Load every .ini once; switching between them later never touches the disk
+    LoadAllProfiles();
+    const auto &entries = registry->Entries();
+    if(!entries.empty()) {
+        std::wcout << L"Available config files: " << entries.size() << L"\n";
+        for(const auto& e : entries) {
+            std::wcout << L" - " << std::wstring(e.name.begin(), e.name.end()) << L"\n";
         }
     } else {
         std::wcout << L"No .ini files found in the CFG directory.\n";
     }
 
     // If no specific iniName provided or last config doesn't exist, use first available .ini
-    if(iniName.empty() && !iniFiles.empty()) {
-        iniName = iniFiles[0];
+    if(iniName.empty() && !entries.empty()) {
+        iniName = entries[0].name;
     }
 
-    // Load the selected or first .ini file
+    // Select the chosen or first profile
     if(!iniName.empty()) {
-        TCHAR path[MAX_PATH];
-        if(GetModuleFileName(NULL, path, MAX_PATH) > 0) {
-            std::wstring full(path);
-            size_t p = full.find_last_of(L"\\/");
-            if(p != std::wstring::npos) {
-                std::wstring folder = full.substr(0, p+1);
-                currentIniPath = std::string(folder.begin(), folder.end()) + "CFG\\" + iniName;
-                if(LoadMacrosFile(currentIniPath)) {
-                    SaveLastConfig(iniName);
-                    std::wcout << L"Macros loaded from " << std::wstring(currentIniPath.begin(), currentIniPath.end()) << L": " << macros.size() << L"\n";
-                    for (size_t i = 0; i < macros.size(); ++i) {
-                        auto m = macros[i];
-                        std::string mode = m->action == Macro::ACTION_AUTOCLICK
-                            ? (m->clickHold ? "HOLD" : "TOGGLE")
-                            : (m->keepOriginal ? "K" : (m->dropOriginal ? "D" : "Default"));
-                        std::wcout << L"#" << (i + 1)
-                                  << L": action=" << (m->action == Macro::ACTION_AUTOCLICK ? L"AutoClick" : L"Bind")
-                                  << L" mode=" << std::wstring(mode.begin(), mode.end())
-                                  << L" triggerCfg=" << m->triggerCfg
-                                  << L" targetCfg=" << m->targetCfg
-                                  << L" intervalMs=" << m->originalIntervalMs;
-                        if(m->action == Macro::ACTION_AUTOCLICK && m->originalIntervalMs > 0){
-                            int cps = static_cast<int>(std::round(1000.0f / m->originalIntervalMs));
-                            std::wcout << L"(-" << cps << L"CPS)";
-                        }
-                        std::wcout << L"\n";
-                    }
-                } else {
-                    std::wcout << L"Failed to load config: " << std::wstring(iniName.begin(), iniName.end()) << L"\n";
-                }
-            }
+        size_t index = registry->Find(iniName);
+        if(index != ProfileRegistry::npos) {
+            SelectProfile(index);
+            std::wcout << L"Macros loaded from " << std::wstring(currentIniPath.begin(), currentIniPath.end()) << L": " << engine->MacroCount() << L"\n";
+            PrintMacros();
+        } else {
+            std::wcout << L"Failed to load config: " << std::wstring(iniName.begin(), iniName.end()) << L"\n";
         }
     } else {
         std::wcout << L"No initial .ini file loaded. Use tray menu to select a config.\n";
@@ -917,16 +711,21 @@ int main(int argc, char** argv){
     originalConsoleProc = (WNDPROC)GetWindowLongPtr(hwndConsole, GWLP_WNDPROC);
     SetWindowLongPtr(hwndConsole, GWLP_WNDPROC, (LONG_PTR)ConsoleWndProc);
 
-    gKeyboardHook = SetWindowsHookExW(WH_KEYBOARD_LL, LowLevelKeyboardProc, nullptr, 0);
-    gMouseHook = SetWindowsHookExW(WH_MOUSE_LL, LowLevelMouseProc, nullptr, 0);
+    if(!capture->Start(recorder)) {
+        std::wcout << (rawInput ? L"Failed to register for Raw Input\n" : L"Failed to install the input hooks\n");
+    }
+    engine->Start();
 
-    timeBeginPeriod(1);
-    for(auto m : macros){
-        if(m->action == Macro::ACTION_AUTOCLICK){
-            if(m->effectiveIntervalMs > 0){
-                m->timerId = timeSetEvent(static_cast<UINT>(m->effectiveIntervalMs), 1, MacroTimerProc, (DWORD_PTR)m, TIME_PERIODIC | TIME_CALLBACK_FUNCTION);
-            }
-        }
+    // Follow the foreground application from now on, starting with the current one
+    focusWatcher.Start(OnForegroundChanged);
+    focusWatcher.Poll();
+
+    // Keep the registry in step with the CFG folder without a manual refresh
+    if(!cfgFolder.empty()) {
+        cfgWatcher.Start(cfgFolder.substr(0, cfgFolder.size() - 1), [](const std::string &file){
+            std::string *name = new std::string(file);
+            if(!PostMessage(hwndTray, WM_CFG_CHANGED, 0, reinterpret_cast<LPARAM>(name))) delete name;
+        });
     }
 
     MSG msg;
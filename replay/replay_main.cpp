@@ -0,0 +1,284 @@
+// unimacro_replay: plays a recorded input trace (.umt) into the engine on a virtual
+// clock, with any profile, and prints the resulting event stream: every input with
+// whether the hook suppressed it, and every injected event, with exact times. Being
+// deterministic, the stream can be kept as a golden file and diffed on later builds.
+//
+//   unimacro_replay [--keymap FILE] [--wake-late US] [--tail MS] [--events]
+//                   [--golden FILE | --write-golden FILE] profile.ini trace.umt
+//
+// --wake-late delays every worker wakeup (after input or at a deadline) by that many
+// microseconds, as timer slack would, to exercise the catch-up path. The exit code is
+// 1 when the stream differs from the golden file, 2 on bad arguments or unreadable input.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Engine.h"
+#include "KeyMap.h"
+#include "SimBackend.h"
+#include "Stats.h"
+
+#if defined(_WIN32)
+#include "Win32Backend.h"
+typedef Win32MappedFile ReplayMappedFile;
+#else
+#include "LinuxBackend.h"
+typedef LinuxMappedFile ReplayMappedFile;
+#endif
+
+// Trace time 0 on the virtual clock; times in the stream are relative to it
+static const uint64_t kOriginNs = 1000000000ull;
+
+static std::string FormatTime(uint64_t ns){
+    char buf[32];
+    ns -= kOriginNs;
+    std::snprintf(buf, sizeof(buf), "%10llu.%06llu", (unsigned long long)(ns / 1000000), (unsigned long long)(ns % 1000000));
+    return buf;
+}
+
+static std::string FormatInput(const TraceRecord &r, bool suppressed){
+    char buf[64];
+    if(r.kind == TraceRecord::WHEEL) std::snprintf(buf, sizeof(buf), "in  wheel  %d", r.wheel);
+    else std::snprintf(buf, sizeof(buf), "in  %-6s 0x%02x %s%s", r.kind == TraceRecord::BUTTON ? "button" : "key",
+                       r.vk, r.down ? "down" : "up", suppressed ? " suppressed" : "");
+    return buf;
+}
+
+static std::string FormatOutput(const InjectOp &op){
+    static const struct { uint32_t flag; const char *name; bool down; } kButtons[] = {
+        { kMouseLeftDown,   "lmb", true },  { kMouseLeftUp,   "lmb", false },
+        { kMouseRightDown,  "rmb", true },  { kMouseRightUp,  "rmb", false },
+        { kMouseMiddleDown, "mmb", true },  { kMouseMiddleUp, "mmb", false },
+        { kMouseXDown,      "x",   true },  { kMouseXUp,      "x",   false },
+    };
+    char buf[64];
+    if(op.type == InjectOp::KEY){
+        std::snprintf(buf, sizeof(buf), "out key    0x%02x %s", op.vk, op.flags & kKeyEventUp ? "up" : "down");
+        return buf;
+    }
+    if(op.flags == kMouseWheel){
+        std::snprintf(buf, sizeof(buf), "out wheel  %d", op.mouseData);
+        return buf;
+    }
+    for(const auto &b : kButtons){
+        if(op.flags != b.flag) continue;
+        if(b.flag == kMouseXDown || b.flag == kMouseXUp) std::snprintf(buf, sizeof(buf), "out button x%d %s", op.mouseData, b.down ? "down" : "up");
+        else std::snprintf(buf, sizeof(buf), "out button %s %s", b.name, b.down ? "down" : "up");
+        return buf;
+    }
+    std::snprintf(buf, sizeof(buf), "out mouse  flags=0x%04x data=%d", op.flags, op.mouseData);
+    return buf;
+}
+
+// ---- Virtual worker ----
+// Runs the engine the way its worker thread would: woken by input and at each deadline,
+// every wakeup landing lateNs after it was asked for. Output is appended to the stream
+// as it is sent, so causes and effects at the same instant keep their order.
+class Replay {
+public:
+    Replay(uint64_t lateNs) : sink(clock), source(clock), engine(sink, clock), lateNs(lateNs) {}
+
+    void RunUntil(uint64_t t){
+        while(wakeNs <= t){
+            clock.AdvanceTo(wakeNs);
+            uint64_t next = engine.RunDue(clock.NowNs());
+            for(; taken < sink.records.size(); ++taken){
+                const SimInputSink::Record &rec = sink.records[taken];
+                stream.push_back(FormatTime(rec.timeNs) + " " + FormatOutput(rec.op));
+                ++outputs;
+                if(awaitingResponse){
+                    response.Record(rec.timeNs - lastInputNs);
+                    awaitingResponse = false;
+                }
+            }
+            wakeNs = next == IClock::kForever ? IClock::kForever : std::max(next, clock.NowNs()) + lateNs;
+        }
+        clock.AdvanceTo(t);
+    }
+
+    void Feed(const TraceRecord &r){
+        RunUntil(kOriginNs + r.timeNs);
+        InputEvent ev = { 0, r.kind == TraceRecord::WHEEL ? uint8_t(0) : r.vk, r.down != 0 };
+        ev.wheel = r.kind == TraceRecord::WHEEL ? static_cast<int16_t>(r.wheel) : int16_t(0);
+        bool suppressed = source.Feed(ev);
+        if(suppressed) ++suppressedInputs;
+        stream.push_back(FormatTime(clock.NowNs()) + " " + FormatInput(r, suppressed));
+        lastInputNs = clock.NowNs();
+        awaitingResponse = true;
+        wakeNs = std::min(wakeNs, clock.NowNs() + lateNs);
+    }
+
+    SimClock clock;
+    SimInputSink sink;
+    SimInputSource source;
+    Engine engine;
+
+    std::vector<std::string> stream;
+    uint64_t suppressedInputs = 0;
+    uint64_t outputs = 0;
+    // Input to the first injected event after it, for inputs that got one before the next input
+    LatencyHistogram response;
+
+private:
+    uint64_t lateNs;
+    uint64_t wakeNs = IClock::kForever;
+    size_t taken = 0;
+    uint64_t lastInputNs = 0;
+    bool awaitingResponse = false;
+};
+
+// ---- Golden files ----
+static std::vector<std::string> ReadLines(const std::string &path, bool &ok){
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    ok = in.good();
+    std::string line;
+    while(std::getline(in, line)){
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        if(line.empty() || line[0] == '#') continue;
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static int CompareGolden(const std::vector<std::string> &got, const std::string &path){
+    bool ok;
+    std::vector<std::string> expected = ReadLines(path, ok);
+    if(!ok){
+        std::fprintf(stderr, "unimacro_replay: cannot read %s\n", path.c_str());
+        return 2;
+    }
+    size_t n = std::max(expected.size(), got.size());
+    size_t differing = 0;
+    for(size_t i = 0; i < n; ++i){
+        const std::string *e = i < expected.size() ? &expected[i] : nullptr;
+        const std::string *g = i < got.size() ? &got[i] : nullptr;
+        if(e && g && *e == *g) continue;
+        // The first few differences are enough to see where the timing moved
+        if(++differing <= 10){
+            std::printf("@@ event %zu\n", i + 1);
+            if(e) std::printf("-%s\n", e->c_str());
+            if(g) std::printf("+%s\n", g->c_str());
+        }
+    }
+    if(differing){
+        std::printf("golden: %zu expected, %zu produced, %zu differ\n", expected.size(), got.size(), differing);
+        return 1;
+    }
+    std::printf("golden: %zu events match\n", got.size());
+    return 0;
+}
+
+static bool WriteGolden(const std::vector<std::string> &stream, const std::string &path,
+                        const std::string &profileName, const std::string &traceName, uint64_t lateNs){
+    FILE *f = std::fopen(path.c_str(), "w");
+    if(!f) return false;
+    std::fprintf(f, "# unimacro_replay %s %s, worker wakeups %llu us late\n", profileName.c_str(), traceName.c_str(),
+                 (unsigned long long)(lateNs / 1000));
+    std::fprintf(f, "#       time ms event\n");
+    for(const auto &line : stream) std::fprintf(f, "%s\n", line.c_str());
+    return std::fclose(f) == 0;
+}
+
+static std::string BaseName(const std::string &path){
+    return path.substr(path.find_last_of("\\/") + 1);
+}
+
+static int Usage(){
+    std::fprintf(stderr, "usage: unimacro_replay [--keymap FILE] [--wake-late US] [--tail MS] [--events]\n"
+                         "                       [--golden FILE | --write-golden FILE] profile.ini trace.umt\n");
+    return 2;
+}
+
+int main(int argc, char **argv){
+    std::string keymapPath, goldenPath, writeGoldenPath;
+    std::vector<std::string> files;
+    uint64_t lateNs = 0, tailNs = 1000000000ull;
+    bool printEvents = false;
+    for(int i = 1; i < argc; ++i){
+        const char *arg = argv[i];
+        if(std::strcmp(arg, "--keymap") == 0 && i + 1 < argc) keymapPath = argv[++i];
+        else if(std::strcmp(arg, "--wake-late") == 0 && i + 1 < argc) lateNs = std::strtoull(argv[++i], nullptr, 10) * 1000;
+        else if(std::strcmp(arg, "--tail") == 0 && i + 1 < argc) tailNs = std::strtoull(argv[++i], nullptr, 10) * 1000000;
+        else if(std::strcmp(arg, "--events") == 0) printEvents = true;
+        else if(std::strcmp(arg, "--golden") == 0 && i + 1 < argc) goldenPath = argv[++i];
+        else if(std::strcmp(arg, "--write-golden") == 0 && i + 1 < argc) writeGoldenPath = argv[++i];
+        else if(arg[0] == '-') return Usage();
+        else files.push_back(arg);
+    }
+    if(files.size() != 2 || (!goldenPath.empty() && !writeGoldenPath.empty())) return Usage();
+    const std::string &profilePath = files[0], &tracePath = files[1];
+    std::string dir = profilePath.substr(0, profilePath.size() - BaseName(profilePath).size());
+
+    // Key names as the app resolves them: the KeyMapping.cfg beside the profile, if any
+    KeyMap keys;
+    if(keymapPath.empty()){
+        std::ifstream nearby(dir + "KeyMapping.cfg");
+        if(nearby.good()) keymapPath = dir + "KeyMapping.cfg";
+    }
+    if(!keymapPath.empty() && !keys.Load(keymapPath)){
+        std::fprintf(stderr, "unimacro_replay: cannot read %s\n", keymapPath.c_str());
+        return 2;
+    }
+
+    std::ifstream ini(profilePath);
+    if(!ini.good()){
+        std::fprintf(stderr, "unimacro_replay: cannot read %s\n", profilePath.c_str());
+        return 2;
+    }
+    Profile *profile = new Profile();
+    std::vector<ParseError> errors;
+    ParseMacros(ini, keys, *profile, &errors);
+    for(const auto &e : errors){
+        std::fprintf(stderr, "%s:%zu:%zu: %s%s\n", BaseName(profilePath).c_str(), e.line, e.column, e.warning ? "warning: " : "",
+                     e.message.c_str());
+    }
+    std::vector<std::string> missingTraces;
+    AttachTraces<ReplayMappedFile>(*profile, dir, &missingTraces);
+    for(const auto &t : missingTraces){
+        std::fprintf(stderr, "%s: cannot read trace %s, its [Replay] does nothing\n", BaseName(profilePath).c_str(), t.c_str());
+    }
+
+    MappedTrace<ReplayMappedFile> trace;
+    if(!trace.Open(tracePath)){
+        std::fprintf(stderr, "unimacro_replay: %s is not a readable trace\n", tracePath.c_str());
+        delete profile;
+        return 2;
+    }
+
+    Replay replay(lateNs);
+    size_t macroCount = profile->macros.size();
+    replay.engine.SetProfile(profile);
+    replay.source.Start(&replay.engine);
+    replay.clock.AdvanceTo(kOriginNs);
+    for(size_t i = 0; i < trace.count; ++i) replay.Feed(trace.records[i]);
+    replay.RunUntil(kOriginNs + trace.DurationNs() + tailNs);
+
+    if(printEvents) for(const auto &line : replay.stream) std::printf("%s\n", line.c_str());
+
+    const LatencyHistogram &resp = replay.response;
+    std::printf("profile  %s: %zu macros\n", BaseName(profilePath).c_str(), macroCount);
+    std::printf("trace    %s: %zu events over %.3f s\n", BaseName(tracePath).c_str(), trace.count, trace.DurationNs() / 1e9);
+    std::printf("input    %zu events, %llu suppressed\n", trace.count, (unsigned long long)replay.suppressedInputs);
+    std::printf("output   %llu events\n", (unsigned long long)replay.outputs);
+    std::printf("response %llu inputs answered, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                (unsigned long long)resp.Count(), resp.Percentile(0.50) / 1e6, resp.Percentile(0.90) / 1e6,
+                resp.Percentile(0.99) / 1e6, resp.Max() / 1e6);
+    WriteStatsTable(replay.engine, std::cout);
+    std::cout.flush();
+
+    if(!writeGoldenPath.empty()){
+        if(!WriteGolden(replay.stream, writeGoldenPath, BaseName(profilePath), BaseName(tracePath), lateNs)){
+            std::fprintf(stderr, "unimacro_replay: cannot write %s\n", writeGoldenPath.c_str());
+            return 2;
+        }
+        std::printf("golden: %zu events written to %s\n", replay.stream.size(), writeGoldenPath.c_str());
+    }
+    if(!goldenPath.empty()) return CompareGolden(replay.stream, goldenPath);
+    return 0;
+}